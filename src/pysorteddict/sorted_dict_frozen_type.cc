@@ -0,0 +1,479 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "sorted_dict_frozen_type.hh"
+#include "sorted_dict_type.hh"
+#include "sorted_dict_utils.hh"
+
+/**
+ * Check whether the given key can be looked up in this frozen sorted
+ * dictionary. On failure, set a Python exception.
+ *
+ * The caller should ensure that the key type is set prior to calling this
+ * method.
+ *
+ * @param key Key.
+ *
+ * @return `true` if the check succeeds, else `false`.
+ */
+bool FrozenSortedDictType::is_key_good(PyObject* key)
+{
+    if (!Py_IS_TYPE(key, this->key_type))
+    {
+        PyErr_Format(PyExc_TypeError, "got key %R of type %R, want key of type %R", key, Py_TYPE(key), this->key_type);
+        return false;
+    }
+    if (this->key_type == &PyTuple_Type && !SortedDictType::are_key_elements_good(key, this->key_element_types))
+    {
+        return false;
+    }
+    if (!SortedDictType::is_key_good(key, this->key_type, this->state))
+    {
+        PyErr_Format(PyExc_ValueError, "got bad key %R of type %R", key, Py_TYPE(key));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Obtain the sort key of the given key (see the sorted dictionary method of
+ * the same name), and check whether it can be looked up in this frozen sorted
+ * dictionary. On failure, set a Python exception.
+ *
+ * The caller should ensure that the key type is set prior to calling this
+ * method.
+ *
+ * @param key Key.
+ *
+ * @return Sort key if successful, else `nullptr`.
+ */
+PyObject* FrozenSortedDictType::sort_key_of(PyObject* key)
+{
+    PyObjectWrapper sort_key(
+        this->key_func == nullptr ? Py_NewRef(key) : PyObject_CallOneArg(this->key_func, key)
+    );  // 🆕
+    if (sort_key == nullptr || !this->is_key_good(sort_key.get()))
+    {
+        return nullptr;
+    }
+    return sort_key.release();
+}
+
+/**
+ * Try to find the given good key using binary search.
+ *
+ * @param key Good key (or sort key, if there is a key function).
+ *
+ * @return The position of the lower bound of the given key and whether it was
+ * found.
+ */
+std::pair<Py_ssize_t, bool> FrozenSortedDictType::try_find(PyObject* key)
+{
+    SortedDictKey sd_key(key, this->state);
+    SortedDictKeyCompare comp;
+    SortedDictKey* sd_keys_end = this->sd_keys + PyTuple_GET_SIZE(this->keys_tuple);
+    SortedDictKey* it = std::lower_bound(this->sd_keys, sd_keys_end, sd_key, comp);
+    return { it - this->sd_keys, it != sd_keys_end && !comp(sd_key, *it) };
+}
+
+void FrozenSortedDictType::Delete(PyObject* self)
+{
+    FrozenSortedDictType* fsd = reinterpret_cast<FrozenSortedDictType*>(self);
+    Py_DECREF(fsd->keys_tuple);
+    Py_DECREF(fsd->values_tuple);
+    Py_XDECREF(fsd->items_tuple);
+    Py_XDECREF(fsd->key_element_types);
+    Py_XDECREF(fsd->key_func);
+    Py_XDECREF(fsd->sort_keys_tuple);
+    delete[] fsd->sd_keys;
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+PyObject* FrozenSortedDictType::repr(void)
+{
+    char const* delimiter = "";
+    char const* actual_delimiter = ", ";
+    std::string this_repr_utf8 = "FrozenSortedDict" LEFT_PARENTHESIS LEFT_CURLY_BRACKET;
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(this->keys_tuple); ++i)
+    {
+        PyObjectWrapper key_repr(PyObject_Repr(PyTuple_GET_ITEM(this->keys_tuple, i)));  // 🆕
+        if (key_repr == nullptr)
+        {
+            return nullptr;
+        }
+        PyObjectWrapper value_repr(PyObject_Repr(PyTuple_GET_ITEM(this->values_tuple, i)));  // 🆕
+        if (value_repr == nullptr)
+        {
+            return nullptr;
+        }
+        Py_ssize_t key_repr_size, value_repr_size;
+        char const* key_repr_utf8 = PyUnicode_AsUTF8AndSize(key_repr.get(), &key_repr_size);
+        char const* value_repr_utf8 = PyUnicode_AsUTF8AndSize(value_repr.get(), &value_repr_size);
+        this_repr_utf8.append(delimiter)
+            .append(key_repr_utf8, key_repr_size)
+            .append(": ")
+            .append(value_repr_utf8, value_repr_size);
+        delimiter = actual_delimiter;
+    }
+    this_repr_utf8.append(RIGHT_CURLY_BRACKET RIGHT_PARENTHESIS);
+    return PyUnicode_FromStringAndSize(this_repr_utf8.data(), this_repr_utf8.size());  // 🆕
+}
+
+/**
+ * Hash the keys and values. The result is cached, because it cannot change.
+ *
+ * @return Hash if successful, else -1.
+ */
+Py_hash_t FrozenSortedDictType::hash(void)
+{
+    if (this->hash_value != -1)
+    {
+        return this->hash_value;
+    }
+    PyObjectWrapper keys_and_values(PyTuple_Pack(2, this->keys_tuple, this->values_tuple));  // 🆕
+    if (keys_and_values == nullptr)
+    {
+        return -1;
+    }
+    this->hash_value = PyObject_Hash(keys_and_values.get());
+    return this->hash_value;
+}
+
+/**
+ * Compare with another frozen sorted dictionary. Two frozen sorted
+ * dictionaries are equal if their keys and values are.
+ *
+ * @param other Other object.
+ * @param op Comparison operator.
+ *
+ * @return Result if successful, else `nullptr`.
+ */
+PyObject* FrozenSortedDictType::richcompare(PyObject* other, int op)
+{
+    if ((op != Py_EQ && op != Py_NE) || !PyObject_TypeCheck(other, this->state->frozen_sorted_dict_type))
+    {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    FrozenSortedDictType* that = reinterpret_cast<FrozenSortedDictType*>(other);
+    int keys_equal = PyObject_RichCompareBool(this->keys_tuple, that->keys_tuple, Py_EQ);
+    if (keys_equal < 0)
+    {
+        return nullptr;
+    }
+    int values_equal = keys_equal == 0 ? 0 : PyObject_RichCompareBool(this->values_tuple, that->values_tuple, Py_EQ);
+    if (values_equal < 0)
+    {
+        return nullptr;
+    }
+    return PyBool_FromLong((values_equal == 1) == (op == Py_EQ));  // 🆕
+}
+
+int FrozenSortedDictType::contains(PyObject* key)
+{
+    if (this->key_type == nullptr)
+    {
+        return 0;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return -1;
+    }
+    return this->try_find(sort_key.get()).second;
+}
+
+Py_ssize_t FrozenSortedDictType::len(void)
+{
+    return PyTuple_GET_SIZE(this->keys_tuple);
+}
+
+PyObject* FrozenSortedDictType::getitem(PyObject* key)
+{
+    if (this->key_type == nullptr)
+    {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [position, found] = this->try_find(sort_key.get());
+    if (!found)
+    {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    return Py_NewRef(PyTuple_GET_ITEM(this->values_tuple, position));  // 🆕
+}
+
+PyObject* FrozenSortedDictType::iter(void)
+{
+    return PyObject_GetIter(this->keys_tuple);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::reversed(void)
+{
+    return PyObject_CallOneArg(reinterpret_cast<PyObject*>(&PyReversed_Type), this->keys_tuple);  // 🆕
+}
+
+/**
+ * Obtain the information required to pickle this frozen sorted dictionary:
+ * its type, its key-value pairs in ascending order of the keys and, if there
+ * is one, its key function (which has to be passed as a keyword argument).
+ * Since they are in ascending order, it is unpickled in linear time.
+ *
+ * @return Tuple if successful, else `nullptr`.
+ */
+PyObject* FrozenSortedDictType::reduce(void)
+{
+    PyObjectWrapper items(this->items());  // 🆕
+    if (items == nullptr)
+    {
+        return nullptr;
+    }
+    if (this->key_func == nullptr)
+    {
+        return Py_BuildValue("O(O)", Py_TYPE(this), items.get());  // 🆕
+    }
+    PyObjectWrapper copyreg(PyImport_ImportModule("copyreg"));  // 🆕
+    if (copyreg == nullptr)
+    {
+        return nullptr;
+    }
+    PyObjectWrapper newobj_ex(PyObject_GetAttrString(copyreg.get(), "__newobj_ex__"));  // 🆕
+    if (newobj_ex == nullptr)
+    {
+        return nullptr;
+    }
+    return Py_BuildValue(
+        "O(O(O){sO})", newobj_ex.get(), Py_TYPE(this), items.get(), "key", this->key_func
+    );  // 🆕
+}
+
+PyObject* FrozenSortedDictType::bisect_left(PyObject* key)
+{
+    if (this->key_type == nullptr)
+    {
+        return PyLong_FromLong(0);  // 🆕
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    return PyLong_FromSsize_t(this->try_find(sort_key.get()).first);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::bisect_right(PyObject* key)
+{
+    if (this->key_type == nullptr)
+    {
+        return PyLong_FromLong(0);  // 🆕
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [position, found] = this->try_find(sort_key.get());
+    return PyLong_FromSsize_t(position + found);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::get(PyObject* const* args, Py_ssize_t nargs)
+{
+    if (!SortedDictType::is_nargs_good(__func__, nargs, 1, 2))
+    {
+        return nullptr;
+    }
+    PyObject* key = args[0];
+    PyObject* Default = nargs > 1 ? args[1] : Py_None;
+    if (this->key_type == nullptr)
+    {
+        return Py_NewRef(Default);  // 🆕
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [position, found] = this->try_find(sort_key.get());
+    return Py_NewRef(found ? PyTuple_GET_ITEM(this->values_tuple, position) : Default);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::index(PyObject* key)
+{
+    if (this->key_type == nullptr)
+    {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [position, found] = this->try_find(sort_key.get());
+    if (!found)
+    {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    return PyLong_FromSsize_t(position);  // 🆕
+}
+
+/**
+ * Obtain the key-value pairs. They are created when first required, and then
+ * reused.
+ *
+ * @return Tuple of key-value pairs if successful, else `nullptr`.
+ */
+PyObject* FrozenSortedDictType::items(void)
+{
+    if (this->items_tuple != nullptr)
+    {
+        return Py_NewRef(this->items_tuple);  // 🆕
+    }
+    Py_ssize_t sz = PyTuple_GET_SIZE(this->keys_tuple);
+    PyObjectWrapper items_tuple(PyTuple_New(sz));  // 🆕
+    if (items_tuple == nullptr)
+    {
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < sz; ++i)
+    {
+        PyObject* item = PyTuple_Pack(
+            2, PyTuple_GET_ITEM(this->keys_tuple, i), PyTuple_GET_ITEM(this->values_tuple, i)
+        );  // 🆕
+        if (item == nullptr)
+        {
+            return nullptr;
+        }
+        PyTuple_SET_ITEM(items_tuple.get(), i, item);
+    }
+    this->items_tuple = items_tuple.release();
+    return Py_NewRef(this->items_tuple);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::keys(void)
+{
+    return Py_NewRef(this->keys_tuple);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::values(void)
+{
+    return Py_NewRef(this->values_tuple);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::get_key(void)
+{
+    if (this->key_func == nullptr)
+    {
+        Py_RETURN_NONE;
+    }
+    return Py_NewRef(this->key_func);  // 🆕
+}
+
+PyObject* FrozenSortedDictType::get_key_type(void)
+{
+    if (this->key_type == nullptr)
+    {
+        Py_RETURN_NONE;
+    }
+    return Py_NewRef(this->key_type);  // 🆕
+}
+
+/**
+ * Create a frozen sorted dictionary from a sorted dictionary (in constant time
+ * plus that required to copy its keys and values) or from anything a sorted
+ * dictionary can be created from (in linear time if the keys are in ascending
+ * order).
+ *
+ * @param type Type.
+ * @param args Positional arguments.
+ * @param kwargs Keyword arguments. Passed on to the sorted dictionary
+ * constructor if any are given.
+ *
+ * @return Frozen sorted dictionary if successful, else `nullptr`.
+ */
+PyObject* FrozenSortedDictType::New(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+    Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+    if (!SortedDictType::is_nargs_good("FrozenSortedDict", nargs, 0, 1))
+    {
+        return nullptr;
+    }
+    SortedDictModuleState* state = sorted_dict_module_state_of(type);
+    bool kwargs_given = kwargs != nullptr && PyDict_GET_SIZE(kwargs) != 0;
+    PyObject* ob = nargs == 1 && !kwargs_given ? PyTuple_GET_ITEM(args, 0) : nullptr;
+    if (ob != nullptr && Py_IS_TYPE(ob, type) && type == state->frozen_sorted_dict_type)
+    {
+        // It cannot change, so it can be reused.
+        return Py_NewRef(ob);  // 🆕
+    }
+
+    // Read the keys and values from a snapshot, so that they cannot change
+    // while being read.
+    PyObjectWrapper sd_ob;
+    if (ob != nullptr && PyObject_TypeCheck(ob, state->sorted_dict_type))
+    {
+        PyCriticalSectionLocker _(ob);
+        sd_ob.reset(reinterpret_cast<SortedDictType*>(ob)->snapshot());  // 🆕
+    }
+    else
+    {
+        sd_ob.reset(PyObject_Call(reinterpret_cast<PyObject*>(state->sorted_dict_type), args, kwargs));  // 🆕
+    }
+    if (sd_ob == nullptr)
+    {
+        return nullptr;
+    }
+    SortedDictType* sd = reinterpret_cast<SortedDictType*>(sd_ob.get());
+    Py_ssize_t sz = sd->len();
+    if (sz < 0)
+    {
+        return nullptr;
+    }
+
+    PyObjectWrapper keys_tuple(PyTuple_New(sz));  // 🆕
+    PyObjectWrapper values_tuple(PyTuple_New(sz));  // 🆕
+    PyObjectWrapper sort_keys_tuple(sd->key_func == nullptr ? nullptr : PyTuple_New(sz));  // 🆕
+    if (keys_tuple == nullptr || values_tuple == nullptr || (sd->key_func != nullptr && sort_keys_tuple == nullptr))
+    {
+        return nullptr;
+    }
+    PyObject* self = type->tp_alloc(type, 0);  // 🆕
+    if (self == nullptr)
+    {
+        return nullptr;
+    }
+    FrozenSortedDictType* fsd = reinterpret_cast<FrozenSortedDictType*>(self);
+    fsd->sd_keys = new SortedDictKey[sz];
+    Py_ssize_t i = 0;
+    for (auto& item : *sd->map)
+    {
+        PyTuple_SET_ITEM(keys_tuple.get(), i, Py_NewRef(item.key));  // 🆕
+        PyTuple_SET_ITEM(values_tuple.get(), i, Py_NewRef(item.second.value));  // 🆕
+        if (sort_keys_tuple != nullptr)
+        {
+            PyTuple_SET_ITEM(sort_keys_tuple.get(), i, Py_NewRef(item.first.ob));  // 🆕
+        }
+        fsd->sd_keys[i++] = item.first;
+    }
+    fsd->keys_tuple = keys_tuple.release();
+    fsd->values_tuple = values_tuple.release();
+    fsd->key_func = Py_XNewRef(sd->key_func);
+    fsd->sort_keys_tuple = sort_keys_tuple.release();
+    fsd->state = state;
+    fsd->key_type = sd->key_type;
+    fsd->key_element_types = Py_XNewRef(sd->key_element_types);
+    fsd->items_tuple = nullptr;
+    fsd->hash_value = -1;
+    return self;
+}
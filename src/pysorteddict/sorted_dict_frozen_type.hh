@@ -0,0 +1,75 @@
+#ifndef SORTED_DICT_FROZEN_TYPE_HH_
+#define SORTED_DICT_FROZEN_TYPE_HH_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <utility>
+
+#include "sorted_dict_module.hh"
+#include "sorted_dict_tree.hh"
+
+struct FrozenSortedDictType
+{
+public:
+    PyObject_HEAD;
+
+private:
+    // The keys in ascending order and the values mapped to them. Tuples store
+    // their elements contiguously, and can be handed out as they are, since
+    // they are immutable.
+    PyObject* keys_tuple;
+    PyObject* values_tuple;
+
+    // Copies of the keys (or sort keys, if there is a key function), so that
+    // a search compares unboxed keys where possible. These do not own
+    // references.
+    SortedDictKey* sd_keys;
+
+    // The key function and the sort keys in ascending order, or null if there
+    // is no key function.
+    PyObject* key_func;
+    PyObject* sort_keys_tuple;
+
+    // State of the module which created the type of this object.
+    SortedDictModuleState* state;
+
+    // The type of each key, or null if there are no keys.
+    PyTypeObject* key_type;
+
+    // If the key type is `tuple`, the type of each element of a key (see the
+    // sorted dictionary member of the same name). Else, null.
+    PyObject* key_element_types;
+
+    // Computed when first required.
+    PyObject* items_tuple;
+    Py_hash_t hash_value;
+
+private:
+    bool is_key_good(PyObject*);
+    PyObject* sort_key_of(PyObject*);
+    std::pair<Py_ssize_t, bool> try_find(PyObject*);
+
+public:
+    static void Delete(PyObject*);
+    PyObject* repr(void);
+    Py_hash_t hash(void);
+    PyObject* richcompare(PyObject*, int);
+    int contains(PyObject*);
+    Py_ssize_t len(void);
+    PyObject* getitem(PyObject*);
+    PyObject* iter(void);
+    PyObject* reversed(void);
+    PyObject* reduce(void);
+    PyObject* bisect_left(PyObject*);
+    PyObject* bisect_right(PyObject*);
+    PyObject* get(PyObject* const*, Py_ssize_t);
+    PyObject* index(PyObject*);
+    PyObject* items(void);
+    PyObject* keys(void);
+    PyObject* values(void);
+    PyObject* get_key(void);
+    PyObject* get_key_type(void);
+    static PyObject* New(PyTypeObject*, PyObject*, PyObject*);
+};
+
+#endif
@@ -1,19 +1,70 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
-#include <map>
 
 #include "sorted_dict_items_type.hh"
 #include "sorted_dict_type.hh"
+#include "sorted_dict_utils.hh"
 #include "sorted_dict_view_type.hh"
 
 template<typename T>
 static PyObject* iterator_to_object(T it)
 {
-    return PyTuple_Pack(2, it->first, it->second.value);  // 🆕
+    // Faster than `PyTuple_Pack`, which has to process a variable number of
+    // arguments.
+    PyObject* item = PyTuple_New(2);  // 🆕
+    if (item == nullptr)
+    {
+        return nullptr;
+    }
+    PyTuple_SET_ITEM(item, 0, Py_NewRef(it->key));  // 🆕
+    PyTuple_SET_ITEM(item, 1, Py_NewRef(it->second.value));  // 🆕
+    return item;
+}
+
+/**
+ * Overwrite a key-value pair with the one a C++ iterator references. The
+ * caller should ensure that no one else can observe the former.
+ *
+ * @param it Iterator.
+ * @param item Key-value pair.
+ */
+template<typename T>
+static void iterator_into_object(T it, PyObject* item)
+{
+    PyObject* key = PyTuple_GET_ITEM(item, 0);
+    PyObject* value = PyTuple_GET_ITEM(item, 1);
+    PyTuple_SET_ITEM(item, 0, Py_NewRef(it->key));  // 🆕
+    PyTuple_SET_ITEM(item, 1, Py_NewRef(it->second.value));  // 🆕
+    Py_DECREF(key);
+    Py_DECREF(value);
+#if PY_VERSION_HEX >= 0x030E0000
+    // The hash of a tuple is cached. It is that of the former key-value pair.
+    reinterpret_cast<PyTupleObject*>(item)->ob_hash = -1;
+#endif
+
+    // The garbage collector stops tracking a tuple if none of the objects in
+    // it can be part of a reference cycle. That may no longer be true.
+    if (!PyObject_GC_IsTracked(item))
+    {
+        PyObject_GC_Track(item);
+    }
+}
+
+template<typename T>
+PyObject* SortedDictItemsIterType<T>::New(PyTypeObject* type, SortedDictType* sd)
+{
+    PyObject* self = SortedDictViewIterType<T>::New(type, sd, iterator_to_object<T>);  // 🆕
+    if (self == nullptr)
+    {
+        return nullptr;
+    }
+    reinterpret_cast<SortedDictItemsIterType<T>*>(self)->iterator_into_object = iterator_into_object<T>;
+    return self;
 }
 
 int SortedDictItemsType::contains(PyObject* item)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 2)
     {
         return 0;
@@ -23,6 +74,18 @@ int SortedDictItemsType::contains(PyObject* item)
     return this->sd->contains(key, value);
 }
 
+PyObject* SortedDictItemsType::iter(PyTypeObject* type)
+{
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
+    return SortedDictItemsIterType<FwdIterType>::New(type, this->sd);
+}
+
+PyObject* SortedDictItemsType::reversed(PyTypeObject* type)
+{
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
+    return SortedDictItemsIterType<RevIterType>::New(type, this->sd);
+}
+
 PyObject* SortedDictItemsType::New(PyTypeObject* type, SortedDictType* sd)
 {
     return SortedDictViewType::New(type, sd, iterator_to_object<FwdIterType>, iterator_to_object<RevIterType>);
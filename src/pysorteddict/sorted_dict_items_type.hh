@@ -9,12 +9,16 @@
 template<typename T>
 struct SortedDictItemsIterType : public SortedDictViewIterType<T>
 {
+public:
+    static PyObject* New(PyTypeObject*, SortedDictType*);
 };
 
 struct SortedDictItemsType : public SortedDictViewType
 {
 public:
     int contains(PyObject*);
+    PyObject* iter(PyTypeObject*);
+    PyObject* reversed(PyTypeObject*);
     static PyObject* New(PyTypeObject*, SortedDictType*);
 };
 
@@ -1,15 +1,15 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
-#include <map>
 
 #include "sorted_dict_keys_type.hh"
 #include "sorted_dict_type.hh"
+#include "sorted_dict_utils.hh"
 #include "sorted_dict_view_type.hh"
 
 template<typename T>
 static PyObject* iterator_to_object(T it)
 {
-    return Py_NewRef(it->first);  // 🆕
+    return Py_NewRef(it->key);  // 🆕
 }
 
 template<typename T>
@@ -18,11 +18,77 @@ PyObject* SortedDictKeysIterType<T>::New(PyTypeObject* type, SortedDictType* sd)
     return SortedDictViewIterType<T>::New(type, sd, iterator_to_object<T>);
 }
 
+template<typename T>
+PyObject* SortedDictKeysIterType<T>::New(
+    PyTypeObject* type, SortedDictType* sd, T it, PyObject* stop, bool stop_inclusive
+)
+{
+    return SortedDictViewIterType<T>::New(type, sd, iterator_to_object<T>, it, stop, stop_inclusive);
+}
+
 int SortedDictKeysType::contains(PyObject* key)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     return this->sd->contains(key);
 }
 
+/**
+ * Remove the key-value pairs at the given position or slice of positions from
+ * the underlying sorted dictionary. Keys cannot be replaced.
+ *
+ * @param idx Index or slice.
+ * @param value Value. Must be `nullptr`.
+ *
+ * @return 0 if successful, else -1.
+ */
+int SortedDictKeysType::setitem(PyObject* idx, PyObject* value)
+{
+    if (value != nullptr)
+    {
+        PyErr_Format(PyExc_TypeError, "'%s' object does not support item assignment", Py_TYPE(this)->tp_name);
+        return -1;
+    }
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
+    if (PyIndex_Check(idx))
+    {
+        Py_ssize_t position = PyNumber_AsSsize_t(idx, PyExc_IndexError);
+        if (position == -1 && PyErr_Occurred() != nullptr)
+        {
+            return -1;
+        }
+        Py_ssize_t sz = this->sd->len();
+        Py_ssize_t positive_position = position >= 0 ? position : position + sz;
+        if (positive_position < 0 || sz <= positive_position)
+        {
+            PyErr_Format(PyExc_IndexError, "got invalid index %zd for view of length %zd", position, sz);
+            return -1;
+        }
+        return this->sd->delete_slice(positive_position, positive_position + 1, 1);
+    }
+
+    if (PySlice_Check(idx))
+    {
+        Py_ssize_t start, stop, step;
+        if (PySlice_Unpack(idx, &start, &stop, &step) != 0)
+        {
+            return -1;
+        }
+        return this->sd->delete_slice(start, stop, step);
+    }
+
+    PyErr_Format(
+        PyExc_TypeError, "got index %R of type %R, want index of type %R or %R", idx, Py_TYPE(idx), &PyLong_Type,
+        &PySlice_Type
+    );
+    return -1;
+}
+
+PyObject* SortedDictKeysType::to_buffer(void)
+{
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
+    return this->sd->keys_to_buffer();
+}
+
 PyObject* SortedDictKeysType::New(PyTypeObject* type, SortedDictType* sd)
 {
     return SortedDictViewType::New(type, sd, iterator_to_object<FwdIterType>, iterator_to_object<RevIterType>);
@@ -11,12 +11,15 @@ struct SortedDictKeysIterType : public SortedDictViewIterType<T>
 {
 public:
     static PyObject* New(PyTypeObject*, SortedDictType*);
+    static PyObject* New(PyTypeObject*, SortedDictType*, T, PyObject*, bool);
 };
 
 struct SortedDictKeysType : public SortedDictViewType
 {
 public:
     int contains(PyObject*);
+    int setitem(PyObject*, PyObject*);
+    PyObject* to_buffer(void);
     static PyObject* New(PyTypeObject*, SortedDictType*);
 };
 
@@ -1,12 +1,23 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <array>
+#include <utility>
 
+#include "sorted_dict_frozen_type.hh"
 #include "sorted_dict_items_type.hh"
 #include "sorted_dict_keys_type.hh"
+#include "sorted_dict_module.hh"
 #include "sorted_dict_type.hh"
 #include "sorted_dict_utils.hh"
 #include "sorted_dict_values_type.hh"
 
+PyDoc_STRVAR(
+    sorted_dict_view_iter_type_next_chunk_doc,
+    "it.next_chunk(n: int, /) -> list[Any]\n"
+    "Return a list of the next ``n`` elements of the iterator ``it``, or of all its remaining elements if there are "
+    "fewer."
+);
+
 /**
  * Deinitialise and deallocate.
  */
@@ -23,20 +34,35 @@ static PyObject* sorted_dict_items_fwd_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictItemsIterType<FwdIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_items_fwd_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictItemsFwdIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictItemsIterType<FwdIterType>),
-    .tp_dealloc = sorted_dict_items_fwd_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Forward iterator over the items in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_items_fwd_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_items_fwd_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictItemsIterType<FwdIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_items_fwd_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_items_fwd_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_items_fwd_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_items_fwd_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Forward iterator over the items in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_items_fwd_iter_type_next) },
+    { Py_tp_methods, sorted_dict_items_fwd_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_items_fwd_iter_type_spec = {
+    .name = "pysorteddict.SortedDictItemsFwdIter",
+    .basicsize = sizeof(SortedDictItemsIterType<FwdIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_items_fwd_iter_type_slots,
 };
 
 /**
@@ -55,20 +81,35 @@ static PyObject* sorted_dict_items_rev_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictItemsIterType<RevIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_items_rev_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictItemsRevIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictItemsIterType<RevIterType>),
-    .tp_dealloc = sorted_dict_items_rev_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Reverse iterator over the items in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_items_rev_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_items_rev_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictItemsIterType<RevIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_items_rev_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_items_rev_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_items_rev_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_items_rev_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Reverse iterator over the items in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_items_rev_iter_type_next) },
+    { Py_tp_methods, sorted_dict_items_rev_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_items_rev_iter_type_spec = {
+    .name = "pysorteddict.SortedDictItemsRevIter",
+    .basicsize = sizeof(SortedDictItemsIterType<RevIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_items_rev_iter_type_slots,
 };
 
 /**
@@ -103,11 +144,6 @@ static int sorted_dict_items_type_contains(PyObject* self, PyObject* item)
     return reinterpret_cast<SortedDictItemsType*>(self)->contains(item);
 }
 
-static PySequenceMethods sorted_dict_items_type_sequence = {
-    .sq_length = sorted_dict_items_type_len,
-    .sq_contains = sorted_dict_items_type_contains,
-};
-
 /**
  * Retrieve the item at a position or items in a slice.
  */
@@ -116,23 +152,21 @@ static PyObject* sorted_dict_items_type_getitem(PyObject* self, PyObject* idx)
     return reinterpret_cast<SortedDictItemsType*>(self)->getitem(idx);
 }
 
-static PyMappingMethods sorted_dict_items_type_mapping = {
-    .mp_subscript = sorted_dict_items_type_getitem,
-};
-
 /**
  * Create a forward iterator.
  */
 static PyObject* sorted_dict_items_type_iter(PyObject* self)
 {
-    return reinterpret_cast<SortedDictItemsType*>(self)->iter(&sorted_dict_items_fwd_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictItemsType*>(self)->iter(state->sorted_dict_items_fwd_iter_type);
 }
 
 PyDoc_STRVAR(sorted_dict_items_type_reversed_doc, "Implement reversed(self).");
 
 static PyObject* sorted_dict_items_type_reversed(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictItemsType*>(self)->reversed(&sorted_dict_items_rev_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictItemsType*>(self)->reversed(state->sorted_dict_items_rev_iter_type);
 }
 
 static PyMethodDef sorted_dict_items_type_methods[] = {
@@ -145,24 +179,24 @@ static PyMethodDef sorted_dict_items_type_methods[] = {
     { nullptr },
 };
 
-static PyTypeObject sorted_dict_items_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictItems",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictItemsType),
-    .tp_dealloc = sorted_dict_items_type_dealloc,
-    .tp_repr = sorted_dict_items_type_repr,
-    .tp_as_sequence = &sorted_dict_items_type_sequence,
-    .tp_as_mapping = &sorted_dict_items_type_mapping,
-    .tp_hash = PyObject_HashNotImplemented,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Dynamic view on the items in a sorted dictionary.",
-    .tp_iter = sorted_dict_items_type_iter,
-    .tp_methods = sorted_dict_items_type_methods,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyType_Slot sorted_dict_items_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_items_type_dealloc) },
+    { Py_tp_repr, reinterpret_cast<void*>(sorted_dict_items_type_repr) },
+    { Py_sq_length, reinterpret_cast<void*>(sorted_dict_items_type_len) },
+    { Py_sq_contains, reinterpret_cast<void*>(sorted_dict_items_type_contains) },
+    { Py_mp_subscript, reinterpret_cast<void*>(sorted_dict_items_type_getitem) },
+    { Py_tp_hash, reinterpret_cast<void*>(PyObject_HashNotImplemented) },
+    { Py_tp_doc, const_cast<char*>("Dynamic view on the items in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(sorted_dict_items_type_iter) },
+    { Py_tp_methods, sorted_dict_items_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_items_type_spec = {
+    .name = "pysorteddict.SortedDictItems",
+    .basicsize = sizeof(SortedDictItemsType),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_items_type_slots,
 };
 
 /**
@@ -181,20 +215,35 @@ static PyObject* sorted_dict_keys_fwd_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictKeysIterType<FwdIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_keys_fwd_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictKeysFwdIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictKeysIterType<FwdIterType>),
-    .tp_dealloc = sorted_dict_keys_fwd_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Forward iterator over the keys in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_keys_fwd_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_keys_fwd_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictKeysIterType<FwdIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_keys_fwd_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_keys_fwd_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_keys_fwd_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_keys_fwd_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Forward iterator over the keys in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_keys_fwd_iter_type_next) },
+    { Py_tp_methods, sorted_dict_keys_fwd_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_keys_fwd_iter_type_spec = {
+    .name = "pysorteddict.SortedDictKeysFwdIter",
+    .basicsize = sizeof(SortedDictKeysIterType<FwdIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_keys_fwd_iter_type_slots,
 };
 
 /**
@@ -213,20 +262,35 @@ static PyObject* sorted_dict_keys_rev_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictKeysIterType<RevIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_keys_rev_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictKeysRevIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictKeysIterType<RevIterType>),
-    .tp_dealloc = sorted_dict_keys_rev_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Reverse iterator over the keys in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_keys_rev_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_keys_rev_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictKeysIterType<RevIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_keys_rev_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_keys_rev_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_keys_rev_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_keys_rev_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Reverse iterator over the keys in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_keys_rev_iter_type_next) },
+    { Py_tp_methods, sorted_dict_keys_rev_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_keys_rev_iter_type_spec = {
+    .name = "pysorteddict.SortedDictKeysRevIter",
+    .basicsize = sizeof(SortedDictKeysIterType<RevIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_keys_rev_iter_type_slots,
 };
 
 /**
@@ -261,11 +325,6 @@ static int sorted_dict_keys_type_contains(PyObject* self, PyObject* key)
     return reinterpret_cast<SortedDictKeysType*>(self)->contains(key);
 }
 
-static PySequenceMethods sorted_dict_keys_type_sequence = {
-    .sq_length = sorted_dict_keys_type_len,
-    .sq_contains = sorted_dict_keys_type_contains,
-};
-
 /**
  * Retrieve the key at a position or keys in a slice.
  */
@@ -274,23 +333,41 @@ static PyObject* sorted_dict_keys_type_getitem(PyObject* self, PyObject* idx)
     return reinterpret_cast<SortedDictKeysType*>(self)->getitem(idx);
 }
 
-static PyMappingMethods sorted_dict_keys_type_mapping = {
-    .mp_subscript = sorted_dict_keys_type_getitem,
-};
+/**
+ * Delete the key at a position or keys in a slice.
+ */
+static int sorted_dict_keys_type_setitem(PyObject* self, PyObject* idx, PyObject* value)
+{
+    return reinterpret_cast<SortedDictKeysType*>(self)->setitem(idx, value);
+}
 
 /**
  * Create a forward iterator.
  */
 static PyObject* sorted_dict_keys_type_iter(PyObject* self)
 {
-    return reinterpret_cast<SortedDictKeysType*>(self)->iter(&sorted_dict_keys_fwd_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictKeysType*>(self)->iter(state->sorted_dict_keys_fwd_iter_type);
 }
 
 PyDoc_STRVAR(sorted_dict_keys_type_reversed_doc, "Implement reversed(self).");
 
 static PyObject* sorted_dict_keys_type_reversed(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictKeysType*>(self)->reversed(&sorted_dict_keys_rev_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictKeysType*>(self)->reversed(state->sorted_dict_keys_rev_iter_type);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_keys_type_to_buffer_doc,
+    "v.to_buffer() -> memoryview\n"
+    "Return a memory view over a contiguous array of the floating-point or integer keys in the sorted dictionary view "
+    "``v``."
+);
+
+static PyObject* sorted_dict_keys_type_to_buffer(PyObject* self, PyObject* args)
+{
+    return reinterpret_cast<SortedDictKeysType*>(self)->to_buffer();
 }
 
 static PyMethodDef sorted_dict_keys_type_methods[] = {
@@ -300,27 +377,34 @@ static PyMethodDef sorted_dict_keys_type_methods[] = {
         .ml_flags = METH_NOARGS,
         .ml_doc = sorted_dict_keys_type_reversed_doc,
     },
+    {
+        .ml_name = "to_buffer",
+        .ml_meth = sorted_dict_keys_type_to_buffer,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = sorted_dict_keys_type_to_buffer_doc,
+    },
     { nullptr },
 };
 
-static PyTypeObject sorted_dict_keys_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictKeys",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictKeysType),
-    .tp_dealloc = sorted_dict_keys_type_dealloc,
-    .tp_repr = sorted_dict_keys_type_repr,
-    .tp_as_sequence = &sorted_dict_keys_type_sequence,
-    .tp_as_mapping = &sorted_dict_keys_type_mapping,
-    .tp_hash = PyObject_HashNotImplemented,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Dynamic view on the keys in a sorted dictionary.",
-    .tp_iter = sorted_dict_keys_type_iter,
-    .tp_methods = sorted_dict_keys_type_methods,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyType_Slot sorted_dict_keys_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_keys_type_dealloc) },
+    { Py_tp_repr, reinterpret_cast<void*>(sorted_dict_keys_type_repr) },
+    { Py_sq_length, reinterpret_cast<void*>(sorted_dict_keys_type_len) },
+    { Py_sq_contains, reinterpret_cast<void*>(sorted_dict_keys_type_contains) },
+    { Py_mp_subscript, reinterpret_cast<void*>(sorted_dict_keys_type_getitem) },
+    { Py_mp_ass_subscript, reinterpret_cast<void*>(sorted_dict_keys_type_setitem) },
+    { Py_tp_hash, reinterpret_cast<void*>(PyObject_HashNotImplemented) },
+    { Py_tp_doc, const_cast<char*>("Dynamic view on the keys in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(sorted_dict_keys_type_iter) },
+    { Py_tp_methods, sorted_dict_keys_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_keys_type_spec = {
+    .name = "pysorteddict.SortedDictKeys",
+    .basicsize = sizeof(SortedDictKeysType),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_keys_type_slots,
 };
 
 /**
@@ -339,20 +423,35 @@ static PyObject* sorted_dict_values_fwd_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictValuesIterType<FwdIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_values_fwd_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictValuesFwdIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictValuesIterType<FwdIterType>),
-    .tp_dealloc = sorted_dict_values_fwd_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Forward iterator over the values in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_values_fwd_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_values_fwd_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictValuesIterType<FwdIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_values_fwd_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_values_fwd_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_values_fwd_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_values_fwd_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Forward iterator over the values in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_values_fwd_iter_type_next) },
+    { Py_tp_methods, sorted_dict_values_fwd_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_values_fwd_iter_type_spec = {
+    .name = "pysorteddict.SortedDictValuesFwdIter",
+    .basicsize = sizeof(SortedDictValuesIterType<FwdIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_values_fwd_iter_type_slots,
 };
 
 /**
@@ -371,20 +470,35 @@ static PyObject* sorted_dict_values_rev_iter_type_next(PyObject* self)
     return reinterpret_cast<SortedDictValuesIterType<RevIterType>*>(self)->next();
 }
 
-static PyTypeObject sorted_dict_values_rev_iter_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictValuesRevIter",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictValuesIterType<RevIterType>),
-    .tp_dealloc = sorted_dict_values_rev_iter_type_dealloc,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Reverse iterator over the values in a sorted dictionary.",
-    .tp_iter = PyObject_SelfIter,
-    .tp_iternext = sorted_dict_values_rev_iter_type_next,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyObject* sorted_dict_values_rev_iter_type_next_chunk(PyObject* self, PyObject* chunk_size)
+{
+    return reinterpret_cast<SortedDictValuesIterType<RevIterType>*>(self)->next_chunk(chunk_size);
+}
+
+static PyMethodDef sorted_dict_values_rev_iter_type_methods[] = {
+    {
+        .ml_name = "next_chunk",
+        .ml_meth = sorted_dict_values_rev_iter_type_next_chunk,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_view_iter_type_next_chunk_doc,
+    },
+    { nullptr },
+};
+
+static PyType_Slot sorted_dict_values_rev_iter_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_values_rev_iter_type_dealloc) },
+    { Py_tp_doc, const_cast<char*>("Reverse iterator over the values in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(PyObject_SelfIter) },
+    { Py_tp_iternext, reinterpret_cast<void*>(sorted_dict_values_rev_iter_type_next) },
+    { Py_tp_methods, sorted_dict_values_rev_iter_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_values_rev_iter_type_spec = {
+    .name = "pysorteddict.SortedDictValuesRevIter",
+    .basicsize = sizeof(SortedDictValuesIterType<RevIterType>),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_values_rev_iter_type_slots,
 };
 
 /**
@@ -411,10 +525,6 @@ static Py_ssize_t sorted_dict_values_type_len(PyObject* self)
     return reinterpret_cast<SortedDictValuesType*>(self)->len();
 }
 
-static PySequenceMethods sorted_dict_values_type_sequence = {
-    .sq_length = sorted_dict_values_type_len,
-};
-
 /**
  * Retrieve the value at a position or values in a slice.
  */
@@ -423,23 +533,21 @@ static PyObject* sorted_dict_values_type_getitem(PyObject* self, PyObject* idx)
     return reinterpret_cast<SortedDictValuesType*>(self)->getitem(idx);
 }
 
-static PyMappingMethods sorted_dict_values_type_mapping = {
-    .mp_subscript = sorted_dict_values_type_getitem,
-};
-
 /**
  * Create a forward iterator.
  */
 static PyObject* sorted_dict_values_type_iter(PyObject* self)
 {
-    return reinterpret_cast<SortedDictValuesType*>(self)->iter(&sorted_dict_values_fwd_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictValuesType*>(self)->iter(state->sorted_dict_values_fwd_iter_type);
 }
 
 PyDoc_STRVAR(sorted_dict_values_type_reversed_doc, "Implement reversed(self).");
 
 static PyObject* sorted_dict_values_type_reversed(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictValuesType*>(self)->reversed(&sorted_dict_values_rev_iter_type);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictValuesType*>(self)->reversed(state->sorted_dict_values_rev_iter_type);
 }
 
 static PyMethodDef sorted_dict_values_type_methods[] = {
@@ -452,23 +560,22 @@ static PyMethodDef sorted_dict_values_type_methods[] = {
     { nullptr },
 };
 
-static PyTypeObject sorted_dict_values_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDictValues",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictValuesType),
-    .tp_dealloc = sorted_dict_values_type_dealloc,
-    .tp_repr = sorted_dict_values_type_repr,
-    .tp_as_sequence = &sorted_dict_values_type_sequence,
-    .tp_as_mapping = &sorted_dict_values_type_mapping,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_DEFAULT,
-    .tp_doc = "Dynamic view on the values in a sorted dictionary.",
-    .tp_iter = sorted_dict_values_type_iter,
-    .tp_methods = sorted_dict_values_type_methods,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_free = PyObject_Free,
+static PyType_Slot sorted_dict_values_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_values_type_dealloc) },
+    { Py_tp_repr, reinterpret_cast<void*>(sorted_dict_values_type_repr) },
+    { Py_sq_length, reinterpret_cast<void*>(sorted_dict_values_type_len) },
+    { Py_mp_subscript, reinterpret_cast<void*>(sorted_dict_values_type_getitem) },
+    { Py_tp_doc, const_cast<char*>("Dynamic view on the values in a sorted dictionary.") },
+    { Py_tp_iter, reinterpret_cast<void*>(sorted_dict_values_type_iter) },
+    { Py_tp_methods, sorted_dict_values_type_methods },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_values_type_spec = {
+    .name = "pysorteddict.SortedDictValues",
+    .basicsize = sizeof(SortedDictValuesType),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = sorted_dict_values_type_slots,
 };
 
 /**
@@ -489,6 +596,7 @@ static void sorted_dict_type_dealloc(PyObject* self)
  */
 static PyObject* sorted_dict_type_repr(PyObject* self)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->repr();
 }
 
@@ -497,18 +605,16 @@ static PyObject* sorted_dict_type_repr(PyObject* self)
  */
 static int sorted_dict_type_contains(PyObject* self, PyObject* key)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->contains(key);
 }
 
-static PySequenceMethods sorted_dict_type_sequence = {
-    .sq_contains = sorted_dict_type_contains,
-};
-
 /**
  * Obtain the number of key-value pairs.
  */
 static Py_ssize_t sorted_dict_type_len(PyObject* self)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->len();
 }
 
@@ -517,6 +623,7 @@ static Py_ssize_t sorted_dict_type_len(PyObject* self)
  */
 static PyObject* sorted_dict_type_getitem(PyObject* self, PyObject* key)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->getitem(key);
 }
 
@@ -525,28 +632,135 @@ static PyObject* sorted_dict_type_getitem(PyObject* self, PyObject* key)
  */
 static int sorted_dict_type_setitem(PyObject* self, PyObject* key, PyObject* value)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->setitem(key, value);
 }
 
-static PyMappingMethods sorted_dict_type_mapping = {
-    .mp_length = sorted_dict_type_len,
-    .mp_subscript = sorted_dict_type_getitem,
-    .mp_ass_subscript = sorted_dict_type_setitem,
-};
+/**
+ * Obtain the object to lock along with a sorted dictionary which is being
+ * updated with the keys and values from the given object. If the latter is a
+ * sorted dictionary, it is read without running Python code, and must not
+ * change meanwhile. Else, it is the former, which is then locked only once.
+ *
+ * Locking both at once rather than one after the other ensures that the lock
+ * on the former is not released while waiting for the lock on the latter.
+ *
+ * @param self Sorted dictionary.
+ * @param ob Object.
+ *
+ * @return Object to lock.
+ */
+static PyObject* update_source_to_lock(PyObject* self, PyObject* ob)
+{
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return ob != nullptr && PyObject_TypeCheck(ob, state->sorted_dict_type) ? ob : self;
+}
+
+/**
+ * Merge two sorted dictionaries into a new one.
+ */
+static PyObject* sorted_dict_type_or(PyObject* a, PyObject* b)
+{
+    // This is also called for the reflected operation, so either operand may
+    // be the sorted dictionary.
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(a));
+    if (state == nullptr)
+    {
+        state = sorted_dict_module_state_of(Py_TYPE(b));
+    }
+    return SortedDictType::or_(a, b, state);
+}
+
+/**
+ * Update in place.
+ */
+static PyObject* sorted_dict_type_ior(PyObject* self, PyObject* ob)
+{
+    PyCriticalSection2Locker _(self, update_source_to_lock(self, ob));
+    return reinterpret_cast<SortedDictType*>(self)->ior(ob);
+}
 
 /**
  * Create a forward iterator.
  */
 static PyObject* sorted_dict_type_iter(PyObject* self)
 {
-    return reinterpret_cast<SortedDictType*>(self)->iter(&sorted_dict_keys_fwd_iter_type);
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->iter(state->sorted_dict_keys_fwd_iter_type);
+}
+
+PyDoc_STRVAR(sorted_dict_type_reduce_doc, "Helper for pickle.");
+
+static PyObject* sorted_dict_type_reduce(PyObject* self, PyObject* args)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->reduce();
 }
 
 PyDoc_STRVAR(sorted_dict_type_reversed_doc, "Implement reversed(self).");
 
 static PyObject* sorted_dict_type_reversed(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictType*>(self)->reversed(&sorted_dict_keys_rev_iter_type);
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->reversed(state->sorted_dict_keys_rev_iter_type);
+}
+
+PyDoc_STRVAR(sorted_dict_type_setstate_doc, "Helper for pickle.");
+
+static PyObject* sorted_dict_type_setstate(PyObject* self, PyObject* state)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->setstate(state);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_bisect_left_doc,
+    "d.bisect_left(key: Any, /) -> int\n"
+    "Return the number of keys in the sorted dictionary ``d`` which are less than ``key``."
+);
+
+static PyObject* sorted_dict_type_bisect_left(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->bisect_left(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_bisect_right_doc,
+    "d.bisect_right(key: Any, /) -> int\n"
+    "Return the number of keys in the sorted dictionary ``d`` which are less than or equal to ``key``."
+);
+
+static PyObject* sorted_dict_type_bisect_right(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->bisect_right(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_ceiling_item_doc,
+    "d.ceiling_item(key: Any, /) -> tuple[Any, Any] | None\n"
+    "Return ``(k, d[k])`` where ``k`` is ``d.ceiling_key(key)``, or ``None`` if the latter is ``None``."
+);
+
+static PyObject* sorted_dict_type_ceiling_item(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->ceiling_item(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_ceiling_key_doc,
+    "d.ceiling_key(key: Any, /) -> Any\n"
+    "Return the smallest key in the sorted dictionary ``d`` not less than ``key``, or ``None`` if there is none."
+);
+
+static PyObject* sorted_dict_type_ceiling_key(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->ceiling_key(key);
 }
 
 PyDoc_STRVAR(
@@ -557,6 +771,7 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_clear(PyObject* self, PyObject* args)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->clear();
 }
 
@@ -568,9 +783,47 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_copy(PyObject* self, PyObject* args)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->copy();
 }
 
+PyDoc_STRVAR(
+    sorted_dict_type_delete_range_doc,
+    "d.delete_range(lo: Any = None, hi: Any = None, inclusive: tuple[bool, bool] = (True, True))\n"
+    "Remove the keys in the sorted dictionary ``d`` which lie between ``lo`` and ``hi``, and the values mapped to "
+    "them."
+);
+
+static PyObject* sorted_dict_type_delete_range(PyObject* self, PyObject* args, PyObject* kwargs)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->delete_range(args, kwargs);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_floor_item_doc,
+    "d.floor_item(key: Any, /) -> tuple[Any, Any] | None\n"
+    "Return ``(k, d[k])`` where ``k`` is ``d.floor_key(key)``, or ``None`` if the latter is ``None``."
+);
+
+static PyObject* sorted_dict_type_floor_item(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->floor_item(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_floor_key_doc,
+    "d.floor_key(key: Any, /) -> Any\n"
+    "Return the greatest key in the sorted dictionary ``d`` not greater than ``key``, or ``None`` if there is none."
+);
+
+static PyObject* sorted_dict_type_floor_key(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->floor_key(key);
+}
+
 PyDoc_STRVAR(
     sorted_dict_type_get_doc,
     "d.get(key: Any, default: Any = None, /) -> Any\n"
@@ -579,9 +832,62 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_get(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->get(args, nargs);
 }
 
+PyDoc_STRVAR(
+    sorted_dict_type_higher_item_doc,
+    "d.higher_item(key: Any, /) -> tuple[Any, Any] | None\n"
+    "Return ``(k, d[k])`` where ``k`` is ``d.higher_key(key)``, or ``None`` if the latter is ``None``."
+);
+
+static PyObject* sorted_dict_type_higher_item(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->higher_item(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_higher_key_doc,
+    "d.higher_key(key: Any, /) -> Any\n"
+    "Return the smallest key in the sorted dictionary ``d`` greater than ``key``, or ``None`` if there is none."
+);
+
+static PyObject* sorted_dict_type_higher_key(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->higher_key(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_index_doc,
+    "d.index(key: Any, /) -> int\n"
+    "Return the position of ``key`` in the sorted dictionary ``d``."
+);
+
+static PyObject* sorted_dict_type_index(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->index(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_irange_doc,
+    "d.irange(lo: Any = None, hi: Any = None, inclusive: tuple[bool, bool] = (True, True), reverse: bool = False) "
+    "-> SortedDictKeysFwdIter | SortedDictKeysRevIter\n"
+    "Return an iterator over the keys in the sorted dictionary ``d`` which lie between ``lo`` and ``hi``."
+);
+
+static PyObject* sorted_dict_type_irange(PyObject* self, PyObject* args, PyObject* kwargs)
+{
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->irange(
+        args, kwargs, state->sorted_dict_keys_fwd_iter_type, state->sorted_dict_keys_rev_iter_type
+    );
+}
+
 PyDoc_STRVAR(
     sorted_dict_type_items_doc,
     "d.items() -> SortedDictItems\n"
@@ -590,7 +896,9 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_items(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictType*>(self)->items(&sorted_dict_items_type);
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->items(state->sorted_dict_items_type);
 }
 
 PyDoc_STRVAR(
@@ -601,7 +909,71 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_keys(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictType*>(self)->keys(&sorted_dict_keys_type);
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->keys(state->sorted_dict_keys_type);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_lower_item_doc,
+    "d.lower_item(key: Any, /) -> tuple[Any, Any] | None\n"
+    "Return ``(k, d[k])`` where ``k`` is ``d.lower_key(key)``, or ``None`` if the latter is ``None``."
+);
+
+static PyObject* sorted_dict_type_lower_item(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->lower_item(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_lower_key_doc,
+    "d.lower_key(key: Any, /) -> Any\n"
+    "Return the greatest key in the sorted dictionary ``d`` less than ``key``, or ``None`` if there is none."
+);
+
+static PyObject* sorted_dict_type_lower_key(PyObject* self, PyObject* key)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->lower_key(key);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_peekitem_doc,
+    "d.peekitem(index: int = -1, /) -> tuple[Any, Any]\n"
+    "Return the key-value pair at position ``index`` in the sorted dictionary ``d``."
+);
+
+static PyObject* sorted_dict_type_peekitem(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->peekitem(args, nargs);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_pop_doc,
+    "d.pop(key: Any, /) -> Any\n"
+    "d.pop(key: Any, default: Any, /) -> Any\n"
+    "Remove ``key`` from the sorted dictionary ``d`` and return the value mapped to it. If ``key`` isn't in ``d``, "
+    "return ``default`` if it is provided, else raise ``KeyError``."
+);
+
+static PyObject* sorted_dict_type_pop(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->pop(args, nargs);
+}
+
+PyDoc_STRVAR(
+    sorted_dict_type_popitem_doc,
+    "d.popitem(index: int = -1, /) -> tuple[Any, Any]\n"
+    "Remove the key-value pair at position ``index`` in the sorted dictionary ``d`` and return it."
+);
+
+static PyObject* sorted_dict_type_popitem(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->popitem(args, nargs);
 }
 
 PyDoc_STRVAR(
@@ -612,9 +984,23 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_setdefault(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->setdefault(args, nargs);
 }
 
+PyDoc_STRVAR(
+    sorted_dict_type_snapshot_doc,
+    "d.snapshot() -> SortedDict\n"
+    "Return a read-only copy of the sorted dictionary ``d``. This takes constant time: the copy shares the keys and "
+    "values with ``d`` until ``d`` is next modified."
+);
+
+static PyObject* sorted_dict_type_snapshot(PyObject* self, PyObject* args)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->snapshot();
+}
+
 PyDoc_STRVAR(
     sorted_dict_type_update_doc,
     "d.update(other: dict | Iterable[Sequence[Any]], **kwargs)\n"
@@ -623,6 +1009,7 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_update(PyObject* self, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames)
 {
+    PyCriticalSection2Locker _(self, update_source_to_lock(self, nargs == 1 ? args[0] : nullptr));
     return reinterpret_cast<SortedDictType*>(self)->update(args, nargs, kwnames);
 }
 
@@ -634,7 +1021,9 @@ PyDoc_STRVAR(
 
 static PyObject* sorted_dict_type_values(PyObject* self, PyObject* args)
 {
-    return reinterpret_cast<SortedDictType*>(self)->values(&sorted_dict_values_type);
+    PyCriticalSectionLocker _(self);
+    SortedDictModuleState* state = sorted_dict_module_state_of(Py_TYPE(self));
+    return reinterpret_cast<SortedDictType*>(self)->values(state->sorted_dict_values_type);
 }
 
 static PyMethodDef sorted_dict_type_methods[] = {
@@ -644,12 +1033,48 @@ static PyMethodDef sorted_dict_type_methods[] = {
         .ml_flags = METH_O | METH_CLASS,
         .ml_doc = "See PEP 585.",
     },
+    {
+        .ml_name = "__reduce__",
+        .ml_meth = sorted_dict_type_reduce,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = sorted_dict_type_reduce_doc,
+    },
     {
         .ml_name = "__reversed__",
         .ml_meth = sorted_dict_type_reversed,
         .ml_flags = METH_NOARGS,
         .ml_doc = sorted_dict_type_reversed_doc,
     },
+    {
+        .ml_name = "__setstate__",
+        .ml_meth = sorted_dict_type_setstate,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_setstate_doc,
+    },
+    {
+        .ml_name = "bisect_left",
+        .ml_meth = sorted_dict_type_bisect_left,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_bisect_left_doc,
+    },
+    {
+        .ml_name = "bisect_right",
+        .ml_meth = sorted_dict_type_bisect_right,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_bisect_right_doc,
+    },
+    {
+        .ml_name = "ceiling_item",
+        .ml_meth = sorted_dict_type_ceiling_item,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_ceiling_item_doc,
+    },
+    {
+        .ml_name = "ceiling_key",
+        .ml_meth = sorted_dict_type_ceiling_key,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_ceiling_key_doc,
+    },
     {
         .ml_name = "clear",
         .ml_meth = sorted_dict_type_clear,
@@ -662,12 +1087,54 @@ static PyMethodDef sorted_dict_type_methods[] = {
         .ml_flags = METH_NOARGS,
         .ml_doc = sorted_dict_type_copy_doc,
     },
+    {
+        .ml_name = "delete_range",
+        .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_delete_range),
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = sorted_dict_type_delete_range_doc,
+    },
+    {
+        .ml_name = "floor_item",
+        .ml_meth = sorted_dict_type_floor_item,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_floor_item_doc,
+    },
+    {
+        .ml_name = "floor_key",
+        .ml_meth = sorted_dict_type_floor_key,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_floor_key_doc,
+    },
     {
         .ml_name = "get",
         .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_get),
         .ml_flags = METH_FASTCALL,
         .ml_doc = sorted_dict_type_get_doc,
     },
+    {
+        .ml_name = "higher_item",
+        .ml_meth = sorted_dict_type_higher_item,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_higher_item_doc,
+    },
+    {
+        .ml_name = "higher_key",
+        .ml_meth = sorted_dict_type_higher_key,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_higher_key_doc,
+    },
+    {
+        .ml_name = "index",
+        .ml_meth = sorted_dict_type_index,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_index_doc,
+    },
+    {
+        .ml_name = "irange",
+        .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_irange),
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = sorted_dict_type_irange_doc,
+    },
     {
         .ml_name = "items",
         .ml_meth = sorted_dict_type_items,
@@ -680,12 +1147,48 @@ static PyMethodDef sorted_dict_type_methods[] = {
         .ml_flags = METH_NOARGS,
         .ml_doc = sorted_dict_type_keys_doc,
     },
+    {
+        .ml_name = "lower_item",
+        .ml_meth = sorted_dict_type_lower_item,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_lower_item_doc,
+    },
+    {
+        .ml_name = "lower_key",
+        .ml_meth = sorted_dict_type_lower_key,
+        .ml_flags = METH_O,
+        .ml_doc = sorted_dict_type_lower_key_doc,
+    },
+    {
+        .ml_name = "peekitem",
+        .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_peekitem),
+        .ml_flags = METH_FASTCALL,
+        .ml_doc = sorted_dict_type_peekitem_doc,
+    },
+    {
+        .ml_name = "pop",
+        .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_pop),
+        .ml_flags = METH_FASTCALL,
+        .ml_doc = sorted_dict_type_pop_doc,
+    },
+    {
+        .ml_name = "popitem",
+        .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_popitem),
+        .ml_flags = METH_FASTCALL,
+        .ml_doc = sorted_dict_type_popitem_doc,
+    },
     {
         .ml_name = "setdefault",
         .ml_meth = reinterpret_cast<PyCFunction>(sorted_dict_type_setdefault),
         .ml_flags = METH_FASTCALL,
         .ml_doc = sorted_dict_type_setdefault_doc,
     },
+    {
+        .ml_name = "snapshot",
+        .ml_meth = sorted_dict_type_snapshot,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = sorted_dict_type_snapshot_doc,
+    },
     {
         // Using the fast calling convention speeds up the common case but
         // slows down the rare case (that of unpacking a dictionary into
@@ -706,23 +1209,43 @@ static PyMethodDef sorted_dict_type_methods[] = {
     { nullptr },
 };
 
+PyDoc_STRVAR(
+    sorted_dict_type_key_doc,
+    "d.key: Callable[[Any], Any] | None\n"
+    "The key function of the sorted dictionary ``d``, or ``None`` if it does not have one."
+);
+
+static PyObject* sorted_dict_type_get_key(PyObject* self, void* closure)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<SortedDictType*>(self)->get_key();
+}
+
 PyDoc_STRVAR(
     sorted_dict_type_key_type_doc,
     "d.key_type: type | None\n"
-    "The key type of the sorted dictionary ``d``, or ``None`` if no key-value pairs have been inserted in it."
+    "The key type (or sort key type, if it has a key function) of the sorted dictionary ``d``, or ``None`` if no "
+    "key-value pairs have been inserted in it."
 );
 
 static PyObject* sorted_dict_type_get_key_type(PyObject* self, void* closure)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->get_key_type();
 }
 
 static int sorted_dict_type_set_key_type(PyObject* self, PyObject* key_type, void* closure)
 {
+    PyCriticalSectionLocker _(self);
     return reinterpret_cast<SortedDictType*>(self)->set_key_type(key_type);
 }
 
 static PyGetSetDef sorted_dict_type_getset[] = {
+    {
+        .name = "key",
+        .get = sorted_dict_type_get_key,
+        .doc = sorted_dict_type_key_doc,
+    },
     {
         .name = "key_type",
         .get = sorted_dict_type_get_key_type,
@@ -737,6 +1260,8 @@ static PyGetSetDef sorted_dict_type_getset[] = {
  */
 static int sorted_dict_type_init(PyObject* self, PyObject* args, PyObject* kwargs)
 {
+    PyObject* ob = PyTuple_GET_SIZE(args) == 1 ? PyTuple_GET_ITEM(args, 0) : nullptr;
+    PyCriticalSection2Locker _(self, update_source_to_lock(self, ob));
     return reinterpret_cast<SortedDictType*>(self)->init(args, kwargs);
 }
 
@@ -752,41 +1277,366 @@ static PyObject* sorted_dict_type_new(PyTypeObject* type, PyObject* args, PyObje
     return SortedDictType::New(type, args, kwargs);
 }
 
-static PyTypeObject sorted_dict_type = {
-    // clang-format off
-    .ob_base = PyVarObject_HEAD_INIT(&PyType_Type, 0)
-    .tp_name = "pysorteddict.SortedDict",
-    // clang-format on
-    .tp_basicsize = sizeof(SortedDictType),
-    .tp_dealloc = sorted_dict_type_dealloc,
-    .tp_repr = sorted_dict_type_repr,
-    .tp_as_sequence = &sorted_dict_type_sequence,
-    .tp_as_mapping = &sorted_dict_type_mapping,
-    .tp_hash = PyObject_HashNotImplemented,
-    .tp_getattro = PyObject_GenericGetAttr,
-    .tp_flags = Py_TPFLAGS_BASETYPE | Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DICT_SUBCLASS,
-    .tp_doc = "Sorted dictionary: a dictionary in which the keys are always in ascending order.\n\n"
-              "See https://tfpf.github.io/pysorteddict/documentation.html.",
-    .tp_iter = sorted_dict_type_iter,
-    .tp_methods = sorted_dict_type_methods,
-    .tp_getset = sorted_dict_type_getset,
-    .tp_init = sorted_dict_type_init,
-    .tp_alloc = PyType_GenericAlloc,
-    .tp_new = sorted_dict_type_new,
-    .tp_free = PyObject_Free,
+PyDoc_STRVAR(
+    sorted_dict_type_doc,
+    "Sorted dictionary: a dictionary in which the keys are always in ascending order.\n\n"
+    "See https://tfpf.github.io/pysorteddict/documentation.html."
+);
+
+static PyType_Slot sorted_dict_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(sorted_dict_type_dealloc) },
+    { Py_tp_repr, reinterpret_cast<void*>(sorted_dict_type_repr) },
+    { Py_sq_contains, reinterpret_cast<void*>(sorted_dict_type_contains) },
+    { Py_mp_length, reinterpret_cast<void*>(sorted_dict_type_len) },
+    { Py_mp_subscript, reinterpret_cast<void*>(sorted_dict_type_getitem) },
+    { Py_mp_ass_subscript, reinterpret_cast<void*>(sorted_dict_type_setitem) },
+    { Py_nb_or, reinterpret_cast<void*>(sorted_dict_type_or) },
+    { Py_nb_inplace_or, reinterpret_cast<void*>(sorted_dict_type_ior) },
+    { Py_tp_hash, reinterpret_cast<void*>(PyObject_HashNotImplemented) },
+    { Py_tp_doc, const_cast<char*>(sorted_dict_type_doc) },
+    { Py_tp_iter, reinterpret_cast<void*>(sorted_dict_type_iter) },
+    { Py_tp_methods, sorted_dict_type_methods },
+    { Py_tp_getset, sorted_dict_type_getset },
+    { Py_tp_init, reinterpret_cast<void*>(sorted_dict_type_init) },
+    { Py_tp_new, reinterpret_cast<void*>(sorted_dict_type_new) },
+    { 0, nullptr },
+};
+
+static PyType_Spec sorted_dict_type_spec = {
+    .name = "pysorteddict.SortedDict",
+    .basicsize = sizeof(SortedDictType),
+    .flags = Py_TPFLAGS_BASETYPE | Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_MAPPING,
+    .slots = sorted_dict_type_slots,
+};
+
+/**
+ * Deinitialise and deallocate.
+ */
+static void frozen_sorted_dict_type_dealloc(PyObject* self)
+{
+    FrozenSortedDictType::Delete(self);
+}
+
+/**
+ * Stringify.
+ */
+static PyObject* frozen_sorted_dict_type_repr(PyObject* self)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->repr();
+}
+
+/**
+ * Hash.
+ */
+static Py_hash_t frozen_sorted_dict_type_hash(PyObject* self)
+{
+    // The hash is cached, so this must be locked.
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<FrozenSortedDictType*>(self)->hash();
+}
+
+/**
+ * Compare.
+ */
+static PyObject* frozen_sorted_dict_type_richcompare(PyObject* self, PyObject* other, int op)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->richcompare(other, op);
+}
+
+/**
+ * Check whether a key is present.
+ */
+static int frozen_sorted_dict_type_contains(PyObject* self, PyObject* key)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->contains(key);
+}
+
+/**
+ * Obtain the number of keys.
+ */
+static Py_ssize_t frozen_sorted_dict_type_len(PyObject* self)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->len();
+}
+
+/**
+ * Find the value mapped to a key.
+ */
+static PyObject* frozen_sorted_dict_type_getitem(PyObject* self, PyObject* key)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->getitem(key);
+}
+
+/**
+ * Create a forward iterator.
+ */
+static PyObject* frozen_sorted_dict_type_iter(PyObject* self)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->iter();
+}
+
+PyDoc_STRVAR(frozen_sorted_dict_type_reduce_doc, "Helper for pickle.");
+
+static PyObject* frozen_sorted_dict_type_reduce(PyObject* self, PyObject* args)
+{
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<FrozenSortedDictType*>(self)->reduce();
+}
+
+PyDoc_STRVAR(frozen_sorted_dict_type_reversed_doc, "Implement reversed(self).");
+
+static PyObject* frozen_sorted_dict_type_reversed(PyObject* self, PyObject* args)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->reversed();
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_bisect_left_doc,
+    "d.bisect_left(key: Any, /) -> int\n"
+    "Return the number of keys in the frozen sorted dictionary ``d`` which are less than ``key``."
+);
+
+static PyObject* frozen_sorted_dict_type_bisect_left(PyObject* self, PyObject* key)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->bisect_left(key);
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_bisect_right_doc,
+    "d.bisect_right(key: Any, /) -> int\n"
+    "Return the number of keys in the frozen sorted dictionary ``d`` which are less than or equal to ``key``."
+);
+
+static PyObject* frozen_sorted_dict_type_bisect_right(PyObject* self, PyObject* key)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->bisect_right(key);
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_get_doc,
+    "d.get(key: Any, default: Any = None, /) -> Any\n"
+    "Return ``d[key]`` if ``key`` is in the frozen sorted dictionary ``d``, else ``default``."
+);
+
+static PyObject* frozen_sorted_dict_type_get(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->get(args, nargs);
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_index_doc,
+    "d.index(key: Any, /) -> int\n"
+    "Return the position of ``key`` in the frozen sorted dictionary ``d``."
+);
+
+static PyObject* frozen_sorted_dict_type_index(PyObject* self, PyObject* key)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->index(key);
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_items_doc,
+    "d.items() -> tuple[tuple[Any, Any], ...]\n"
+    "Return the key-value pairs in the frozen sorted dictionary ``d``."
+);
+
+static PyObject* frozen_sorted_dict_type_items(PyObject* self, PyObject* args)
+{
+    // The key-value pairs are cached, so this must be locked.
+    PyCriticalSectionLocker _(self);
+    return reinterpret_cast<FrozenSortedDictType*>(self)->items();
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_keys_doc,
+    "d.keys() -> tuple[Any, ...]\n"
+    "Return the keys in the frozen sorted dictionary ``d``."
+);
+
+static PyObject* frozen_sorted_dict_type_keys(PyObject* self, PyObject* args)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->keys();
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_values_doc,
+    "d.values() -> tuple[Any, ...]\n"
+    "Return the values in the frozen sorted dictionary ``d``."
+);
+
+static PyObject* frozen_sorted_dict_type_values(PyObject* self, PyObject* args)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->values();
+}
+
+static PyMethodDef frozen_sorted_dict_type_methods[] = {
+    {
+        .ml_name = "__class_getitem__",
+        .ml_meth = Py_GenericAlias,
+        .ml_flags = METH_O | METH_CLASS,
+        .ml_doc = "See PEP 585.",
+    },
+    {
+        .ml_name = "__reduce__",
+        .ml_meth = frozen_sorted_dict_type_reduce,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = frozen_sorted_dict_type_reduce_doc,
+    },
+    {
+        .ml_name = "__reversed__",
+        .ml_meth = frozen_sorted_dict_type_reversed,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = frozen_sorted_dict_type_reversed_doc,
+    },
+    {
+        .ml_name = "bisect_left",
+        .ml_meth = frozen_sorted_dict_type_bisect_left,
+        .ml_flags = METH_O,
+        .ml_doc = frozen_sorted_dict_type_bisect_left_doc,
+    },
+    {
+        .ml_name = "bisect_right",
+        .ml_meth = frozen_sorted_dict_type_bisect_right,
+        .ml_flags = METH_O,
+        .ml_doc = frozen_sorted_dict_type_bisect_right_doc,
+    },
+    {
+        .ml_name = "get",
+        .ml_meth = reinterpret_cast<PyCFunction>(frozen_sorted_dict_type_get),
+        .ml_flags = METH_FASTCALL,
+        .ml_doc = frozen_sorted_dict_type_get_doc,
+    },
+    {
+        .ml_name = "index",
+        .ml_meth = frozen_sorted_dict_type_index,
+        .ml_flags = METH_O,
+        .ml_doc = frozen_sorted_dict_type_index_doc,
+    },
+    {
+        .ml_name = "items",
+        .ml_meth = frozen_sorted_dict_type_items,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = frozen_sorted_dict_type_items_doc,
+    },
+    {
+        .ml_name = "keys",
+        .ml_meth = frozen_sorted_dict_type_keys,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = frozen_sorted_dict_type_keys_doc,
+    },
+    {
+        .ml_name = "values",
+        .ml_meth = frozen_sorted_dict_type_values,
+        .ml_flags = METH_NOARGS,
+        .ml_doc = frozen_sorted_dict_type_values_doc,
+    },
+    { nullptr },
+};
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_key_doc,
+    "d.key: Callable[[Any], Any] | None\n"
+    "The key function of the frozen sorted dictionary ``d``, or ``None`` if it does not have one."
+);
+
+static PyObject* frozen_sorted_dict_type_get_key(PyObject* self, void* closure)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->get_key();
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_key_type_doc,
+    "d.key_type: type | None\n"
+    "The key type (or sort key type, if it has a key function) of the frozen sorted dictionary ``d``, or ``None`` if "
+    "it is empty and was not created from a sorted dictionary with a key type."
+);
+
+static PyObject* frozen_sorted_dict_type_get_key_type(PyObject* self, void* closure)
+{
+    return reinterpret_cast<FrozenSortedDictType*>(self)->get_key_type();
+}
+
+static PyGetSetDef frozen_sorted_dict_type_getset[] = {
+    {
+        .name = "key",
+        .get = frozen_sorted_dict_type_get_key,
+        .doc = frozen_sorted_dict_type_key_doc,
+    },
+    {
+        .name = "key_type",
+        .get = frozen_sorted_dict_type_get_key_type,
+        .doc = frozen_sorted_dict_type_key_type_doc,
+    },
+    { nullptr },
+};
+
+/**
+ * Allocate and initialise.
+ */
+static PyObject* frozen_sorted_dict_type_new(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+    return FrozenSortedDictType::New(type, args, kwargs);
+}
+
+PyDoc_STRVAR(
+    frozen_sorted_dict_type_doc,
+    "Frozen sorted dictionary: an immutable, hashable sorted dictionary stored in contiguous arrays.\n\n"
+    "See https://tfpf.github.io/pysorteddict/documentation.html."
+);
+
+static PyType_Slot frozen_sorted_dict_type_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(frozen_sorted_dict_type_dealloc) },
+    { Py_tp_repr, reinterpret_cast<void*>(frozen_sorted_dict_type_repr) },
+    { Py_sq_contains, reinterpret_cast<void*>(frozen_sorted_dict_type_contains) },
+    { Py_mp_length, reinterpret_cast<void*>(frozen_sorted_dict_type_len) },
+    { Py_mp_subscript, reinterpret_cast<void*>(frozen_sorted_dict_type_getitem) },
+    { Py_tp_hash, reinterpret_cast<void*>(frozen_sorted_dict_type_hash) },
+    { Py_tp_richcompare, reinterpret_cast<void*>(frozen_sorted_dict_type_richcompare) },
+    { Py_tp_doc, const_cast<char*>(frozen_sorted_dict_type_doc) },
+    { Py_tp_iter, reinterpret_cast<void*>(frozen_sorted_dict_type_iter) },
+    { Py_tp_methods, frozen_sorted_dict_type_methods },
+    { Py_tp_getset, frozen_sorted_dict_type_getset },
+    { Py_tp_new, reinterpret_cast<void*>(frozen_sorted_dict_type_new) },
+    { 0, nullptr },
+};
+
+static PyType_Spec frozen_sorted_dict_type_spec = {
+    .name = "pysorteddict.FrozenSortedDict",
+    .basicsize = sizeof(FrozenSortedDictType),
+    .flags = Py_TPFLAGS_BASETYPE | Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_MAPPING,
+    .slots = frozen_sorted_dict_type_slots,
 };
 
 static int sorted_dict_module_exec(PyObject* mod)
 {
-    if (PyType_Ready(&sorted_dict_items_fwd_iter_type) < 0 || PyType_Ready(&sorted_dict_items_rev_iter_type) < 0
-        || PyType_Ready(&sorted_dict_items_type) < 0 || PyType_Ready(&sorted_dict_keys_fwd_iter_type) < 0
-        || PyType_Ready(&sorted_dict_keys_rev_iter_type) < 0 || PyType_Ready(&sorted_dict_keys_type) < 0
-        || PyType_Ready(&sorted_dict_values_fwd_iter_type) < 0 || PyType_Ready(&sorted_dict_values_rev_iter_type) < 0
-        || PyType_Ready(&sorted_dict_values_type) < 0 || PyType_Ready(&sorted_dict_type) < 0)
+    SortedDictModuleState* state = static_cast<SortedDictModuleState*>(PyModule_GetState(mod));
+    std::pair<PyType_Spec*, PyTypeObject**> specs_and_types[] = {
+        { &sorted_dict_items_fwd_iter_type_spec, &state->sorted_dict_items_fwd_iter_type },
+        { &sorted_dict_items_rev_iter_type_spec, &state->sorted_dict_items_rev_iter_type },
+        { &sorted_dict_items_type_spec, &state->sorted_dict_items_type },
+        { &sorted_dict_keys_fwd_iter_type_spec, &state->sorted_dict_keys_fwd_iter_type },
+        { &sorted_dict_keys_rev_iter_type_spec, &state->sorted_dict_keys_rev_iter_type },
+        { &sorted_dict_keys_type_spec, &state->sorted_dict_keys_type },
+        { &sorted_dict_values_fwd_iter_type_spec, &state->sorted_dict_values_fwd_iter_type },
+        { &sorted_dict_values_rev_iter_type_spec, &state->sorted_dict_values_rev_iter_type },
+        { &sorted_dict_values_type_spec, &state->sorted_dict_values_type },
+        { &sorted_dict_type_spec, &state->sorted_dict_type },
+        { &frozen_sorted_dict_type_spec, &state->frozen_sorted_dict_type },
+    };
+    for (auto [spec, type] : specs_and_types)
+    {
+        *type = reinterpret_cast<PyTypeObject*>(PyType_FromModuleAndSpec(mod, spec, nullptr));  // 🆕
+        if (*type == nullptr)
+        {
+            return -1;
+        }
+    }
+    if (PyModule_AddObjectRef(mod, "SortedDict", reinterpret_cast<PyObject*>(state->sorted_dict_type)) < 0)  // 🆕
     {
         return -1;
     }
-    if (PyModule_AddObjectRef(mod, "SortedDict", reinterpret_cast<PyObject*>(&sorted_dict_type)) < 0)  // 🆕
+    if (PyModule_AddObjectRef(mod, "FrozenSortedDict", reinterpret_cast<PyObject*>(state->frozen_sorted_dict_type))
+        < 0)  // 🆕
     {
         return -1;
     }
@@ -809,13 +1659,81 @@ static int sorted_dict_module_exec(PyObject* mod)
     return 0;
 }
 
+/**
+ * Obtain the locations of all Python objects in the module state.
+ *
+ * @param state Module state.
+ *
+ * @return Locations.
+ */
+static std::array<PyTypeObject**, 27> sorted_dict_module_state_members(SortedDictModuleState* state)
+{
+    return {
+        &state->sorted_dict_items_fwd_iter_type,
+        &state->sorted_dict_items_rev_iter_type,
+        &state->sorted_dict_items_type,
+        &state->sorted_dict_keys_fwd_iter_type,
+        &state->sorted_dict_keys_rev_iter_type,
+        &state->sorted_dict_keys_type,
+        &state->sorted_dict_values_fwd_iter_type,
+        &state->sorted_dict_values_rev_iter_type,
+        &state->sorted_dict_values_type,
+        &state->sorted_dict_type,
+        &state->frozen_sorted_dict_type,
+        &state->PyDate_Type,
+        &state->PyTimeDelta_Type,
+        &state->PyDecimal_Type,
+        &state->PyFraction_Type,
+        &state->PyIPv4Address_Type,
+        &state->PyIPv4Interface_Type,
+        &state->PyIPv4Network_Type,
+        &state->PyIPv6Address_Type,
+        &state->PyIPv6Interface_Type,
+        &state->PyIPv6Network_Type,
+        &state->PyPosixPath_Type,
+        &state->PyPurePosixPath_Type,
+        &state->PyPureWindowsPath_Type,
+        &state->PyWindowsPath_Type,
+        &state->PyStructTime_Type,
+        &state->PyUUID_Type,
+    };
+}
+
+static int sorted_dict_module_traverse(PyObject* mod, visitproc visit, void* arg)
+{
+    SortedDictModuleState* state = static_cast<SortedDictModuleState*>(PyModule_GetState(mod));
+    for (PyTypeObject** type : sorted_dict_module_state_members(state))
+    {
+        Py_VISIT(*type);
+    }
+    Py_VISIT(state->datetime_capsule);
+    return 0;
+}
+
+static int sorted_dict_module_clear(PyObject* mod)
+{
+    SortedDictModuleState* state = static_cast<SortedDictModuleState*>(PyModule_GetState(mod));
+    for (PyTypeObject** type : sorted_dict_module_state_members(state))
+    {
+        Py_CLEAR(*type);
+    }
+    state->datetime_capi = nullptr;
+    Py_CLEAR(state->datetime_capsule);
+    return 0;
+}
+
+static void sorted_dict_module_free(void* mod)
+{
+    sorted_dict_module_clear(static_cast<PyObject*>(mod));
+}
+
 static PyModuleDef_Slot sorted_dict_module_slots[] = {
     { Py_mod_exec, reinterpret_cast<void*>(sorted_dict_module_exec) },
 #if PY_VERSION_HEX >= 0x030C0000
-    { Py_mod_multiple_interpreters, Py_MOD_MULTIPLE_INTERPRETERS_NOT_SUPPORTED },
+    { Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED },
 #endif
 #if PY_VERSION_HEX >= 0x030D0000
-    { Py_mod_gil, Py_MOD_GIL_USED },
+    { Py_mod_gil, Py_MOD_GIL_NOT_USED },
 #endif
     { 0, nullptr },
 };
@@ -825,10 +1743,60 @@ static PyModuleDef sorted_dict_module = {
     .m_name = "pysorteddict",
     .m_doc = "enriches Python with a sorted dictionary\n\n"
              "See https://tfpf.github.io/pysorteddict/.",
-    .m_size = 0,
+    .m_size = sizeof(SortedDictModuleState),
     .m_slots = sorted_dict_module_slots,
+    .m_traverse = sorted_dict_module_traverse,
+    .m_clear = sorted_dict_module_clear,
+    .m_free = sorted_dict_module_free,
 };
 
+/**
+ * Obtain the state of the module which created the given type or its nearest
+ * ancestor created by this module. (Types created by this module can be
+ * subclassed in Python.)
+ *
+ * @param type Type.
+ *
+ * @return Module state, or `nullptr` if neither the given type nor any of its
+ * ancestors was created by this module.
+ */
+SortedDictModuleState* sorted_dict_module_state_of(PyTypeObject* type)
+{
+#if PY_VERSION_HEX >= 0x030B0000
+    PyObject* mod = PyType_GetModuleByDef(type, &sorted_dict_module);
+    if (mod == nullptr)
+    {
+        PyErr_Clear();
+    }
+#else
+    PyObject* mod = nullptr;
+    PyObject* mro = type->tp_mro;
+    for (Py_ssize_t i = 0; mod == nullptr && i < PyTuple_GET_SIZE(mro); ++i)
+    {
+        PyTypeObject* ancestor = reinterpret_cast<PyTypeObject*>(PyTuple_GET_ITEM(mro, i));
+        if (!PyType_HasFeature(ancestor, Py_TPFLAGS_HEAPTYPE))
+        {
+            continue;
+        }
+        mod = PyType_GetModule(ancestor);
+        if (mod == nullptr)
+        {
+            // Defined in Python.
+            PyErr_Clear();
+        }
+        else if (PyModule_GetDef(mod) != &sorted_dict_module)
+        {
+            mod = nullptr;
+        }
+    }
+#endif
+    if (mod == nullptr)
+    {
+        return nullptr;
+    }
+    return static_cast<SortedDictModuleState*>(PyModule_GetState(mod));
+}
+
 PyMODINIT_FUNC PyInit_pysorteddict(void)
 {
     return PyModuleDef_Init(&sorted_dict_module);
@@ -0,0 +1,63 @@
+#ifndef SORTED_DICT_MODULE_HH_
+#define SORTED_DICT_MODULE_HH_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <datetime.h>
+
+// The C API of the `datetime` module is kept in the module state rather than
+// in the global variable this header defines, because every interpreter has
+// its own.
+[[maybe_unused]] extern PyDateTime_CAPI* PyDateTimeAPI;
+
+/**
+ * State of the module. Every interpreter which imports the module gets its own
+ * copy of it, so that no Python objects are shared between interpreters.
+ */
+struct SortedDictModuleState
+{
+    PyTypeObject* sorted_dict_items_fwd_iter_type;
+    PyTypeObject* sorted_dict_items_rev_iter_type;
+    PyTypeObject* sorted_dict_items_type;
+    PyTypeObject* sorted_dict_keys_fwd_iter_type;
+    PyTypeObject* sorted_dict_keys_rev_iter_type;
+    PyTypeObject* sorted_dict_keys_type;
+    PyTypeObject* sorted_dict_values_fwd_iter_type;
+    PyTypeObject* sorted_dict_values_rev_iter_type;
+    PyTypeObject* sorted_dict_values_type;
+    PyTypeObject* sorted_dict_type;
+    PyTypeObject* frozen_sorted_dict_type;
+
+    // Key types which have to be imported explicitly. They are imported when
+    // first required rather than when the module is, because importing them
+    // takes a while.
+    bool key_types_imported;
+#ifdef Py_GIL_DISABLED
+    PyMutex key_types_mutex;
+#endif
+    PyTypeObject* PyDate_Type;
+    PyTypeObject* PyTimeDelta_Type;
+    PyTypeObject* PyDecimal_Type;
+    PyTypeObject* PyFraction_Type;
+    PyTypeObject* PyIPv4Address_Type;
+    PyTypeObject* PyIPv4Interface_Type;
+    PyTypeObject* PyIPv4Network_Type;
+    PyTypeObject* PyIPv6Address_Type;
+    PyTypeObject* PyIPv6Interface_Type;
+    PyTypeObject* PyIPv6Network_Type;
+    PyTypeObject* PyPosixPath_Type;
+    PyTypeObject* PyPurePosixPath_Type;
+    PyTypeObject* PyPureWindowsPath_Type;
+    PyTypeObject* PyWindowsPath_Type;
+    PyTypeObject* PyStructTime_Type;
+    PyTypeObject* PyUUID_Type;
+
+    // The C API of the `datetime` module, through which dates and time deltas
+    // are recognised, and the capsule which owns it.
+    PyObject* datetime_capsule;
+    PyDateTime_CAPI* datetime_capi;
+};
+
+SortedDictModuleState* sorted_dict_module_state_of(PyTypeObject*);
+
+#endif
@@ -0,0 +1,1081 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "sorted_dict_tree.hh"
+#include "sorted_dict_utils.hh"
+
+/**
+ * Split the given non-negative integer which fits in 128 bits into its upper
+ * and lower halves.
+ *
+ * @param ob Integer.
+ * @param hi Upper half.
+ * @param lo Lower half.
+ *
+ * @return `true` if successful, else `false`.
+ */
+static bool split_uint128(PyObject* ob, unsigned long long& hi, unsigned long long& lo)
+{
+    if (!PyLong_CheckExact(ob))
+    {
+        return false;
+    }
+    PyObjectWrapper shift(PyLong_FromLong(64));  // 🆕
+    if (shift == nullptr)
+    {
+        return false;
+    }
+    PyObjectWrapper upper(PyNumber_Rshift(ob, shift.get()));  // 🆕
+    if (upper == nullptr)
+    {
+        return false;
+    }
+    hi = PyLong_AsUnsignedLongLong(upper.get());
+    lo = PyLong_AsUnsignedLongLongMask(ob);
+    return !PyErr_Occurred();
+}
+
+/**
+ * Store an unboxed copy of this key if it is of one of the non-built-in types
+ * ordered by one or a pair of integers, so that comparing two such keys does
+ * not call their Python-level comparison methods. If the integers cannot be
+ * obtained, leave this key boxed; it will then be compared in Python, which is
+ * slower but gives the same result.
+ *
+ * @param state Module state.
+ */
+void SortedDictKey::unbox(SortedDictModuleState* state)
+{
+    PyTypeObject* type = Py_TYPE(this->ob);
+    if (state->datetime_capi != nullptr && type == state->datetime_capi->DateType)
+    {
+        // Dates are ordered by year, then month, then day.
+        this->kind = Kind::INT64;
+        this->native.ll = PyDateTime_GET_YEAR(this->ob) << 9 | PyDateTime_GET_MONTH(this->ob) << 5
+            | PyDateTime_GET_DAY(this->ob);
+        return;
+    }
+    if (state->datetime_capi != nullptr && type == state->datetime_capi->DeltaType)
+    {
+        // Time deltas are ordered by days, then seconds, then microseconds.
+        // Only the number of days may be negative; flipping its sign bit
+        // makes it order the same way as an unsigned integer.
+        this->kind = Kind::UINT128;
+        this->native.u128.hi = static_cast<unsigned long long>(PyDateTime_DELTA_GET_DAYS(this->ob)) ^ 1ULL << 63;
+        this->native.u128.lo = PyDateTime_DELTA_GET_SECONDS(this->ob) * 1000000ULL
+            + PyDateTime_DELTA_GET_MICROSECONDS(this->ob);
+        return;
+    }
+    char const* attr;
+    if (type == state->PyIPv4Address_Type || type == state->PyIPv6Address_Type)
+    {
+        attr = "_ip";
+    }
+    else if (type == state->PyUUID_Type)
+    {
+        attr = "int";
+    }
+    else
+    {
+        return;
+    }
+
+    // IP addresses and UUIDs are ordered by the integers they wrap.
+    PyErrorClearer _;
+    PyObjectWrapper integer(PyObject_GetAttrString(this->ob, attr));  // 🆕
+    if (integer == nullptr)
+    {
+        return;
+    }
+    if (type == state->PyIPv4Address_Type)
+    {
+        int overflow;
+        long long ll = PyLong_AsLongLongAndOverflow(integer.get(), &overflow);
+        if (overflow == 0 && !PyErr_Occurred())
+        {
+            this->kind = Kind::INT64;
+            this->native.ll = ll;
+        }
+        return;
+    }
+    unsigned long long hi, lo;
+    if (split_uint128(integer.get(), hi, lo))
+    {
+        this->kind = Kind::UINT128;
+        this->native.u128.hi = hi;
+        this->native.u128.lo = lo;
+    }
+}
+
+/**
+ * Abbreviate a string. The code points are encoded in UTF-8 (surrogates
+ * included), because the order of the encoded byte strings is that of the
+ * strings.
+ *
+ * @param ob String.
+ *
+ * @return Abbreviated key.
+ */
+unsigned long long SortedDictKey::abbreviate_unicode(PyObject* ob)
+{
+    Py_ssize_t len = PyUnicode_GET_LENGTH(ob);
+    if (PyUnicode_IS_ASCII(ob))
+    {
+        // Already encoded.
+        return abbreviate(static_cast<char const*>(PyUnicode_DATA(ob)), len);
+    }
+    int kind = PyUnicode_KIND(ob);
+    void const* data = PyUnicode_DATA(ob);
+    char buf[sizeof(unsigned long long) + 3];
+    Py_ssize_t size = 0;
+    for (Py_ssize_t i = 0; i < len && size < Py_ssize_t(sizeof(unsigned long long)); ++i)
+    {
+        Py_UCS4 code_point = PyUnicode_READ(kind, data, i);
+        if (code_point < 0x80)
+        {
+            buf[size++] = code_point;
+        }
+        else if (code_point < 0x800)
+        {
+            buf[size++] = 0xC0 | code_point >> 6;
+            buf[size++] = 0x80 | (code_point & 0x3F);
+        }
+        else if (code_point < 0x10000)
+        {
+            buf[size++] = 0xE0 | code_point >> 12;
+            buf[size++] = 0x80 | (code_point >> 6 & 0x3F);
+            buf[size++] = 0x80 | (code_point & 0x3F);
+        }
+        else
+        {
+            buf[size++] = 0xF0 | code_point >> 18;
+            buf[size++] = 0x80 | (code_point >> 12 & 0x3F);
+            buf[size++] = 0x80 | (code_point >> 6 & 0x3F);
+            buf[size++] = 0x80 | (code_point & 0x3F);
+        }
+    }
+    return abbreviate(buf, size);
+}
+
+/**
+ * Compare two elements of tuple keys. They should be of the same type, and
+ * instances of that type should be totally ordered.
+ *
+ * @param a First element.
+ * @param b Second element.
+ *
+ * @return Negative, zero or positive if the first element is less than, equal
+ * to or greater than the second.
+ */
+static int compare_elements(PyObject* a, PyObject* b)
+{
+    if (a == b)
+    {
+        return 0;
+    }
+    if (PyFloat_CheckExact(a))
+    {
+        double a_d = PyFloat_AS_DOUBLE(a);
+        double b_d = PyFloat_AS_DOUBLE(b);
+        return (a_d > b_d) - (a_d < b_d);
+    }
+    if (PyLong_CheckExact(a))
+    {
+        int a_overflow, b_overflow;
+        long long a_ll = PyLong_AsLongLongAndOverflow(a, &a_overflow);
+        long long b_ll = PyLong_AsLongLongAndOverflow(b, &b_overflow);
+        if (a_overflow == 0 && b_overflow == 0)
+        {
+            return (a_ll > b_ll) - (a_ll < b_ll);
+        }
+        if (a_overflow != b_overflow)
+        {
+            // The overflow indicators are ordered like the integers.
+            return (a_overflow > b_overflow) - (a_overflow < b_overflow);
+        }
+    }
+    else if (PyBool_Check(a))
+    {
+        return Py_IsTrue(a) - Py_IsTrue(b);
+    }
+    else if (PyUnicode_CheckExact(a))
+    {
+        return PyUnicode_Compare(a, b);
+    }
+    else if (PyBytes_CheckExact(a))
+    {
+        return SortedDictKeyCompare::compare_bytes(a, b);
+    }
+    if (PyObject_RichCompareBool(a, b, Py_LT) == 1)
+    {
+        return -1;
+    }
+    return PyObject_RichCompareBool(b, a, Py_LT) == 1;
+}
+
+/**
+ * Compare two tuple keys lexicographically, like Python does, but without
+ * calling into Python for elements of the built-in key types. Elements at the
+ * same position should be of the same type.
+ *
+ * @param a First tuple.
+ * @param b Second tuple.
+ *
+ * @return Negative, zero or positive if the first tuple is less than, equal to
+ * or greater than the second.
+ */
+int SortedDictKeyCompare::compare_tuples(PyObject* a, PyObject* b)
+{
+    Py_ssize_t a_size = PyTuple_GET_SIZE(a);
+    Py_ssize_t b_size = PyTuple_GET_SIZE(b);
+    for (Py_ssize_t i = 0; i < std::min(a_size, b_size); ++i)
+    {
+        int result = compare_elements(PyTuple_GET_ITEM(a, i), PyTuple_GET_ITEM(b, i));
+        if (result != 0)
+        {
+            return result;
+        }
+    }
+    return (a_size > b_size) - (a_size < b_size);
+}
+
+SortedDictTree::SortedDictTree(void) : count(0), owners(1), successor(nullptr)
+{
+    this->root = this->first_leaf = this->last_leaf = this->new_leaf();
+}
+
+/**
+ * Copy the structure of the given tree. Only the key-value pairs are copied;
+ * the caller should update the reference counts of the keys and values.
+ *
+ * @param that Tree to copy.
+ */
+SortedDictTree::SortedDictTree(SortedDictTree const& that) : SortedDictTree()
+{
+    std::vector<SortedDictTreeEntry*> entries;
+    entries.reserve(that.count);
+    for (auto& item : that)
+    {
+        entries.push_back(this->entry_pool.create(item.first, item.key, item.second.value));
+    }
+    this->build(entries);
+}
+
+SortedDictTree::~SortedDictTree(void)
+{
+    this->destroy();
+}
+
+/**
+ * Allocate an empty leaf which is not linked to any node.
+ *
+ * @return Leaf.
+ */
+SortedDictTreeLeaf* SortedDictTree::new_leaf(void)
+{
+    SortedDictTreeLeaf* leaf = this->leaf_pool.create();
+    leaf->parent = nullptr;
+    leaf->slot = 0;
+    leaf->size = 0;
+    leaf->is_leaf = true;
+    leaf->prev = leaf->next = nullptr;
+    return leaf;
+}
+
+/**
+ * Allocate an internal node without children which is not linked to any node.
+ *
+ * @return Internal node.
+ */
+SortedDictTreeInternal* SortedDictTree::new_internal(void)
+{
+    SortedDictTreeInternal* internal = this->internal_pool.create();
+    internal->parent = nullptr;
+    internal->slot = 0;
+    internal->size = 0;
+    internal->is_leaf = false;
+    return internal;
+}
+
+/**
+ * Insert a key-value pair into a leaf, splitting it if it is full.
+ *
+ * @param leaf Leaf.
+ * @param pos Position in the leaf at which to insert.
+ * @param entry Key-value pair.
+ */
+void SortedDictTree::insert_into_leaf(SortedDictTreeLeaf* leaf, unsigned short pos, SortedDictTreeEntry* entry)
+{
+    if (leaf->size == SORTED_DICT_TREE_WIDTH)
+    {
+        SortedDictTreeLeaf* right = this->new_leaf();
+        unsigned short half = SORTED_DICT_TREE_WIDTH / 2;
+        right->size = SORTED_DICT_TREE_WIDTH - half;
+        std::copy(leaf->keys + half, leaf->keys + SORTED_DICT_TREE_WIDTH, right->keys);
+        std::copy(leaf->entries + half, leaf->entries + SORTED_DICT_TREE_WIDTH, right->entries);
+        for (unsigned short i = 0; i < right->size; ++i)
+        {
+            right->entries[i]->leaf = right;
+        }
+        leaf->size = half;
+
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next != nullptr)
+        {
+            leaf->next->prev = right;
+        }
+        else
+        {
+            this->last_leaf = right;
+        }
+        leaf->next = right;
+
+        Py_INCREF(right->keys[0].ob);  // 🆕
+        this->insert_into_parent(leaf, right->keys[0], right);
+        if (pos > half)
+        {
+            leaf = right;
+            pos -= half;
+        }
+    }
+    std::copy_backward(leaf->keys + pos, leaf->keys + leaf->size, leaf->keys + leaf->size + 1);
+    std::copy_backward(leaf->entries + pos, leaf->entries + leaf->size, leaf->entries + leaf->size + 1);
+    leaf->keys[pos] = entry->first;
+    leaf->entries[pos] = entry;
+    entry->leaf = leaf;
+    ++leaf->size;
+    this->update_counts(leaf, 1);
+}
+
+/**
+ * Insert a node just after its left sibling, splitting their parent if it is
+ * full. Create a new root if the left sibling is the root.
+ *
+ * @param left Left sibling.
+ * @param separator Separator key. Its reference is stolen.
+ * @param right Node.
+ */
+void SortedDictTree::insert_into_parent(
+    SortedDictTreeNode* left, SortedDictKey const& separator, SortedDictTreeNode* right
+)
+{
+    SortedDictTreeInternal* parent = left->parent;
+    if (parent == nullptr)
+    {
+        parent = this->new_internal();
+        parent->size = 2;
+        parent->keys[0] = separator;
+        parent->children[0] = left;
+        parent->children[1] = right;
+        parent->counts[0] = this->count_of(left);
+        parent->counts[1] = this->count_of(right);
+        left->parent = right->parent = parent;
+        left->slot = 0;
+        right->slot = 1;
+        this->root = parent;
+        return;
+    }
+
+    int idx = left->slot + 1;
+    if (parent->size == SORTED_DICT_TREE_WIDTH)
+    {
+        SortedDictTreeInternal* sibling = this->new_internal();
+        int half = SORTED_DICT_TREE_WIDTH / 2;
+        sibling->size = SORTED_DICT_TREE_WIDTH - half;
+        SortedDictKey middle = parent->keys[half - 1];
+        std::copy(parent->keys + half, parent->keys + SORTED_DICT_TREE_WIDTH - 1, sibling->keys);
+        for (int i = 0; i < sibling->size; ++i)
+        {
+            sibling->children[i] = parent->children[half + i];
+            sibling->children[i]->parent = sibling;
+            sibling->children[i]->slot = i;
+            sibling->counts[i] = parent->counts[half + i];
+        }
+        parent->size = half;
+        this->insert_into_parent(parent, middle, sibling);
+        if (idx > half)
+        {
+            parent = sibling;
+            idx -= half;
+        }
+    }
+    for (int i = parent->size; i > idx; --i)
+    {
+        parent->children[i] = parent->children[i - 1];
+        parent->children[i]->slot = i;
+        parent->counts[i] = parent->counts[i - 1];
+    }
+    std::copy_backward(parent->keys + idx - 1, parent->keys + parent->size - 1, parent->keys + parent->size);
+    parent->keys[idx - 1] = separator;
+    parent->children[idx] = right;
+    right->parent = parent;
+    right->slot = idx;
+    ++parent->size;
+
+    // The key-value pairs in the right sibling were in the left sibling, so
+    // the counts of the ancestors do not change.
+    parent->counts[idx - 1] = this->count_of(left);
+    parent->counts[idx] = this->count_of(right);
+}
+
+/**
+ * Remove a node which is not the first child of its parent from the latter.
+ *
+ * @param node Node.
+ *
+ * @return The separator key to the left of the node. The caller owns its
+ * reference.
+ */
+SortedDictKey SortedDictTree::remove_from_parent(SortedDictTreeNode* node)
+{
+    SortedDictTreeInternal* parent = node->parent;
+    int slot = node->slot;
+    SortedDictKey separator = parent->keys[slot - 1];
+    for (int i = slot; i < parent->size - 1; ++i)
+    {
+        parent->children[i] = parent->children[i + 1];
+        parent->children[i]->slot = i;
+        parent->counts[i] = parent->counts[i + 1];
+    }
+    std::copy(parent->keys + slot, parent->keys + parent->size - 1, parent->keys + slot - 1);
+    --parent->size;
+    return separator;
+}
+
+/**
+ * Restore the minimum occupancy of a leaf by merging it with a sibling or by
+ * moving keys from a sibling into it.
+ *
+ * @param leaf Leaf.
+ *
+ * @return Separator key which is no longer referenced by the tree, if any.
+ * The caller owns its reference, and should release it only after the tree
+ * is consistent again, since doing so may run arbitrary code.
+ */
+PyObject* SortedDictTree::rebalance_leaf(SortedDictTreeLeaf* leaf)
+{
+    if (leaf->parent == nullptr || leaf->size >= SORTED_DICT_TREE_MIN_WIDTH)
+    {
+        return nullptr;
+    }
+    SortedDictTreeInternal* parent = leaf->parent;
+    SortedDictTreeLeaf* left;
+    SortedDictTreeLeaf* right;
+    if (leaf->slot > 0)
+    {
+        left = static_cast<SortedDictTreeLeaf*>(parent->children[leaf->slot - 1]);
+        right = leaf;
+    }
+    else
+    {
+        left = leaf;
+        right = static_cast<SortedDictTreeLeaf*>(parent->children[1]);
+    }
+
+    if (left->size + right->size <= SORTED_DICT_TREE_WIDTH)
+    {
+        std::copy(right->keys, right->keys + right->size, left->keys + left->size);
+        std::copy(right->entries, right->entries + right->size, left->entries + left->size);
+        for (unsigned short i = 0; i < right->size; ++i)
+        {
+            right->entries[i]->leaf = left;
+        }
+        left->size += right->size;
+        parent->counts[left->slot] += parent->counts[right->slot];
+        left->next = right->next;
+        if (right->next != nullptr)
+        {
+            right->next->prev = left;
+        }
+        else
+        {
+            this->last_leaf = left;
+        }
+        SortedDictKey separator = this->remove_from_parent(right);
+        this->leaf_pool.destroy(right);
+        this->rebalance_internal(parent);
+        return separator.ob;
+    }
+
+    int total = left->size + right->size;
+    int left_size = total / 2;
+    if (left->size < left_size)
+    {
+        int moved = left_size - left->size;
+        std::copy(right->keys, right->keys + moved, left->keys + left->size);
+        std::copy(right->entries, right->entries + moved, left->entries + left->size);
+        std::copy(right->keys + moved, right->keys + right->size, right->keys);
+        std::copy(right->entries + moved, right->entries + right->size, right->entries);
+    }
+    else
+    {
+        int moved = left->size - left_size;
+        std::copy_backward(right->keys, right->keys + right->size, right->keys + right->size + moved);
+        std::copy_backward(right->entries, right->entries + right->size, right->entries + right->size + moved);
+        std::copy(left->keys + left_size, left->keys + left->size, right->keys);
+        std::copy(left->entries + left_size, left->entries + left->size, right->entries);
+    }
+    left->size = left_size;
+    right->size = total - left_size;
+    parent->counts[left->slot] = left->size;
+    parent->counts[right->slot] = right->size;
+    for (unsigned short i = 0; i < left->size; ++i)
+    {
+        left->entries[i]->leaf = left;
+    }
+    for (unsigned short i = 0; i < right->size; ++i)
+    {
+        right->entries[i]->leaf = right;
+    }
+    SortedDictKey& separator = parent->keys[right->slot - 1];
+    PyObject* released = separator.ob;
+    separator = right->keys[0];
+    Py_INCREF(separator.ob);  // 🆕
+    return released;
+}
+
+/**
+ * Restore the minimum occupancy of an internal node by merging it with a
+ * sibling or by moving children from a sibling into it. Shrink the tree if
+ * the root has only one child.
+ *
+ * @param node Internal node.
+ */
+void SortedDictTree::rebalance_internal(SortedDictTreeInternal* node)
+{
+    if (node->parent == nullptr)
+    {
+        if (node->size == 1)
+        {
+            this->root = node->children[0];
+            this->root->parent = nullptr;
+            this->root->slot = 0;
+            this->internal_pool.destroy(node);
+        }
+        return;
+    }
+    if (node->size >= SORTED_DICT_TREE_MIN_WIDTH)
+    {
+        return;
+    }
+    SortedDictTreeInternal* parent = node->parent;
+    SortedDictTreeInternal* left;
+    SortedDictTreeInternal* right;
+    if (node->slot > 0)
+    {
+        left = static_cast<SortedDictTreeInternal*>(parent->children[node->slot - 1]);
+        right = node;
+    }
+    else
+    {
+        left = node;
+        right = static_cast<SortedDictTreeInternal*>(parent->children[1]);
+    }
+    SortedDictKey& separator = parent->keys[right->slot - 1];
+
+    if (left->size + right->size <= SORTED_DICT_TREE_WIDTH)
+    {
+        // The separator moves down, so the reference it owns is not released.
+        left->keys[left->size - 1] = separator;
+        std::copy(right->keys, right->keys + right->size - 1, left->keys + left->size);
+        for (int i = 0; i < right->size; ++i)
+        {
+            left->children[left->size + i] = right->children[i];
+            left->children[left->size + i]->parent = left;
+            left->children[left->size + i]->slot = left->size + i;
+            left->counts[left->size + i] = right->counts[i];
+        }
+        left->size += right->size;
+        parent->counts[left->slot] += parent->counts[right->slot];
+        this->remove_from_parent(right);
+        this->internal_pool.destroy(right);
+        this->rebalance_internal(parent);
+        return;
+    }
+
+    // Rotate children through the parent.
+    SortedDictKey keys[2 * SORTED_DICT_TREE_WIDTH];
+    SortedDictTreeNode* children[2 * SORTED_DICT_TREE_WIDTH];
+    std::size_t counts[2 * SORTED_DICT_TREE_WIDTH];
+    int total = left->size + right->size;
+    std::copy(left->children, left->children + left->size, children);
+    std::copy(right->children, right->children + right->size, children + left->size);
+    std::copy(left->counts, left->counts + left->size, counts);
+    std::copy(right->counts, right->counts + right->size, counts + left->size);
+    std::copy(left->keys, left->keys + left->size - 1, keys);
+    keys[left->size - 1] = separator;
+    std::copy(right->keys, right->keys + right->size - 1, keys + left->size);
+    int left_size = total / 2;
+    left->size = left_size;
+    right->size = total - left_size;
+    std::copy(keys, keys + left_size - 1, left->keys);
+    separator = keys[left_size - 1];
+    std::copy(keys + left_size, keys + total - 1, right->keys);
+    for (int i = 0; i < total; ++i)
+    {
+        SortedDictTreeInternal* owner = i < left_size ? left : right;
+        int slot = i < left_size ? i : i - left_size;
+        owner->children[slot] = children[i];
+        owner->counts[slot] = counts[i];
+        children[i]->parent = owner;
+        children[i]->slot = slot;
+    }
+    parent->counts[left->slot] = this->count_of(left);
+    parent->counts[right->slot] = this->count_of(right);
+}
+
+/**
+ * Replace the contents of this empty tree with the given key-value pairs,
+ * building it bottom-up in linear time.
+ *
+ * @param entries Key-value pairs in ascending order of the keys.
+ */
+void SortedDictTree::build(std::vector<SortedDictTreeEntry*> const& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+    this->leaf_pool.destroy(static_cast<SortedDictTreeLeaf*>(this->root));
+
+    // Distribute the key-value pairs as evenly as possible, so that every
+    // leaf has at least the minimum number of them.
+    std::vector<SortedDictTreeNode*> level;
+    std::vector<SortedDictKey> level_keys;
+    std::vector<std::size_t> level_counts;
+    std::size_t leaves = (entries.size() + SORTED_DICT_TREE_BULK_WIDTH - 1) / SORTED_DICT_TREE_BULK_WIDTH;
+    SortedDictTreeLeaf* prev = nullptr;
+    for (std::size_t i = 0, start = 0; i < leaves; ++i)
+    {
+        SortedDictTreeLeaf* leaf = this->new_leaf();
+        leaf->size = entries.size() / leaves + (i < entries.size() % leaves);
+        leaf->prev = prev;
+        if (prev != nullptr)
+        {
+            prev->next = leaf;
+        }
+        for (unsigned short j = 0; j < leaf->size; ++j)
+        {
+            leaf->keys[j] = entries[start + j]->first;
+            leaf->entries[j] = entries[start + j];
+            leaf->entries[j]->leaf = leaf;
+        }
+        start += leaf->size;
+        level.push_back(leaf);
+        level_keys.push_back(leaf->keys[0]);
+        level_counts.push_back(leaf->size);
+        prev = leaf;
+    }
+    this->first_leaf = static_cast<SortedDictTreeLeaf*>(level.front());
+    this->last_leaf = static_cast<SortedDictTreeLeaf*>(level.back());
+
+    // The smallest key in the subtree rooted at each node separates it from
+    // its left sibling.
+    while (level.size() > 1)
+    {
+        std::vector<SortedDictTreeNode*> next_level;
+        std::vector<SortedDictKey> next_level_keys;
+        std::vector<std::size_t> next_level_counts;
+        std::size_t parents = (level.size() + SORTED_DICT_TREE_BULK_WIDTH - 1) / SORTED_DICT_TREE_BULK_WIDTH;
+        for (std::size_t i = 0, start = 0; i < parents; ++i)
+        {
+            SortedDictTreeInternal* node = this->new_internal();
+            node->size = level.size() / parents + (i < level.size() % parents);
+            std::size_t node_count = 0;
+            for (unsigned short j = 0; j < node->size; ++j)
+            {
+                node->children[j] = level[start + j];
+                node->children[j]->parent = node;
+                node->children[j]->slot = j;
+                node->counts[j] = level_counts[start + j];
+                node_count += node->counts[j];
+                if (j > 0)
+                {
+                    node->keys[j - 1] = level_keys[start + j];
+                    Py_INCREF(node->keys[j - 1].ob);  // 🆕
+                }
+            }
+            next_level.push_back(node);
+            next_level_keys.push_back(level_keys[start]);
+            next_level_counts.push_back(node_count);
+            start += node->size;
+        }
+        level.swap(next_level);
+        level_keys.swap(next_level_keys);
+        level_counts.swap(next_level_counts);
+    }
+    this->root = level.front();
+    this->count = entries.size();
+}
+
+/**
+ * Release the separator keys in a subtree.
+ *
+ * @param node Root of the subtree.
+ */
+void SortedDictTree::release_separators(SortedDictTreeNode* node)
+{
+    if (node->is_leaf)
+    {
+        return;
+    }
+    SortedDictTreeInternal* internal = static_cast<SortedDictTreeInternal*>(node);
+    for (unsigned short i = 0; i < internal->size; ++i)
+    {
+        if (i > 0)
+        {
+            Py_DECREF(internal->keys[i - 1].ob);
+        }
+        this->release_separators(internal->children[i]);
+    }
+}
+
+/**
+ * Deallocate all nodes and key-value pairs. Release the separator keys, but
+ * not the keys and values of the key-value pairs.
+ */
+void SortedDictTree::destroy(void)
+{
+    this->release_separators(this->root);
+    this->entry_pool.clear();
+    this->leaf_pool.clear();
+    this->internal_pool.clear();
+}
+
+/**
+ * Find the separator key which is the lower bound of the keys in the subtree
+ * rooted at a node. The node should not be on the leftmost path of the tree.
+ *
+ * @param node Node.
+ *
+ * @return Separator key.
+ */
+SortedDictKey const& SortedDictTree::lower_separator(SortedDictTreeNode* node)
+{
+    while (node->slot == 0)
+    {
+        node = node->parent;
+    }
+    return node->parent->keys[node->slot - 1];
+}
+
+/**
+ * Count the key-value pairs in the subtree rooted at a node.
+ *
+ * @param node Node.
+ *
+ * @return Count.
+ */
+std::size_t SortedDictTree::count_of(SortedDictTreeNode* node)
+{
+    if (node->is_leaf)
+    {
+        return node->size;
+    }
+    SortedDictTreeInternal* internal = static_cast<SortedDictTreeInternal*>(node);
+    return std::accumulate(internal->counts, internal->counts + internal->size, std::size_t(0));
+}
+
+/**
+ * Update the counts of the key-value pairs in the subtrees rooted at the
+ * ancestors of a node.
+ *
+ * @param node Node.
+ * @param delta Change in the number of key-value pairs in the subtree rooted
+ * at the node.
+ */
+void SortedDictTree::update_counts(SortedDictTreeNode* node, std::ptrdiff_t delta)
+{
+    for (; node->parent != nullptr; node = node->parent)
+    {
+        node->parent->counts[node->slot] += delta;
+    }
+}
+
+SortedDictTree::iterator SortedDictTree::lower_bound(SortedDictKey const& key) const
+{
+    SortedDictKeyCompare comp;
+    SortedDictTreeNode* node = this->root;
+    while (!node->is_leaf)
+    {
+        SortedDictTreeInternal* internal = static_cast<SortedDictTreeInternal*>(node);
+        auto separator = std::upper_bound(internal->keys, internal->keys + internal->size - 1, key, comp);
+        node = internal->children[separator - internal->keys];
+    }
+    SortedDictTreeLeaf* leaf = static_cast<SortedDictTreeLeaf*>(node);
+    unsigned short idx = std::lower_bound(leaf->keys, leaf->keys + leaf->size, key, comp) - leaf->keys;
+    if (idx < leaf->size)
+    {
+        return { this, leaf->entries[idx] };
+    }
+    return { this, leaf->next == nullptr ? nullptr : leaf->next->entries[0] };
+}
+
+/**
+ * Find the key-value pair at the given position.
+ *
+ * @param pos Position.
+ *
+ * @return Iterator to the key-value pair if the position is less than the
+ * size, else the end iterator.
+ */
+SortedDictTree::iterator SortedDictTree::nth(std::size_t pos) const
+{
+    if (pos >= this->count)
+    {
+        return this->end();
+    }
+    SortedDictTreeNode* node = this->root;
+    while (!node->is_leaf)
+    {
+        SortedDictTreeInternal* internal = static_cast<SortedDictTreeInternal*>(node);
+        unsigned short idx = 0;
+        for (; pos >= internal->counts[idx]; ++idx)
+        {
+            pos -= internal->counts[idx];
+        }
+        node = internal->children[idx];
+    }
+    return { this, static_cast<SortedDictTreeLeaf*>(node)->entries[pos] };
+}
+
+/**
+ * Find the position of the key-value pair an iterator points to.
+ *
+ * @param it Iterator.
+ *
+ * @return Position if the iterator is not the end iterator, else the size.
+ */
+std::size_t SortedDictTree::rank(iterator it) const
+{
+    if (it.entry == nullptr)
+    {
+        return this->count;
+    }
+    SortedDictTreeNode* node = it.entry->leaf;
+    std::size_t pos = it.entry->leaf->index_of(it.entry);
+    for (; node->parent != nullptr; node = node->parent)
+    {
+        pos = std::accumulate(node->parent->counts, node->parent->counts + node->slot, pos);
+    }
+    return pos;
+}
+
+/**
+ * Move an iterator by the given number of positions. Short distances are
+ * covered one key-value pair at a time, and long distances by looking up the
+ * target position.
+ *
+ * @param it Iterator.
+ * @param distance Number of positions. The target position must be valid.
+ *
+ * @return Iterator to the key-value pair at the target position.
+ */
+SortedDictTree::iterator SortedDictTree::advance(iterator it, std::ptrdiff_t distance) const
+{
+    if (distance > SORTED_DICT_TREE_WIDTH || distance < -SORTED_DICT_TREE_WIDTH)
+    {
+        return this->nth(this->rank(it) + distance);
+    }
+    for (; distance > 0; --distance)
+    {
+        ++it;
+    }
+    for (; distance < 0; ++distance)
+    {
+        --it;
+    }
+    return it;
+}
+
+/**
+ * Insert a key-value pair just before the given position. The caller should
+ * ensure that the given position is the lower bound of the key and that the
+ * key is absent.
+ *
+ * @param hint Position.
+ * @param key Key to compare.
+ * @param ob Key as inserted.
+ * @param value Value.
+ *
+ * @return Iterator to the inserted key-value pair.
+ */
+SortedDictTree::iterator SortedDictTree::emplace_hint(
+    iterator hint, SortedDictKey const& key, PyObject* ob, PyObject* value
+)
+{
+    SortedDictTreeEntry* entry = this->entry_pool.create(key, ob, value);
+    SortedDictTreeLeaf* leaf;
+    unsigned short pos;
+    if (hint.entry == nullptr)
+    {
+        leaf = this->last_leaf;
+        pos = leaf->size;
+    }
+    else
+    {
+        leaf = hint.entry->leaf;
+        pos = leaf->index_of(hint.entry);
+
+        // The key lies between the last key of the previous leaf and the
+        // first key of this one. It belongs in whichever of them the
+        // separator between them admits it into.
+        if (pos == 0 && leaf->prev != nullptr && this->key_comp()(key, this->lower_separator(leaf)))
+        {
+            leaf = leaf->prev;
+            pos = leaf->size;
+        }
+    }
+    this->insert_into_leaf(leaf, pos, entry);
+    ++this->count;
+    return { this, entry };
+}
+
+/**
+ * Insert key-value pairs into this empty tree in linear time. Do not update
+ * the reference counts of their keys and values.
+ *
+ * @param items Key-value pairs in strictly ascending order of the keys.
+ */
+void SortedDictTree::assign(std::vector<SortedDictTreeEntry> const& items)
+{
+    this->clear();
+    std::vector<SortedDictTreeEntry*> entries;
+    entries.reserve(items.size());
+    for (auto& item : items)
+    {
+        entries.push_back(this->entry_pool.create(item));
+    }
+    this->build(entries);
+}
+
+/**
+ * Erase a key-value pair. Do not update the reference counts of its key and
+ * value.
+ *
+ * @param it Position of the key-value pair.
+ */
+void SortedDictTree::erase(iterator it)
+{
+    SortedDictTreeEntry* entry = it.entry;
+    SortedDictTreeLeaf* leaf = entry->leaf;
+    unsigned short pos = leaf->index_of(entry);
+    std::copy(leaf->keys + pos + 1, leaf->keys + leaf->size, leaf->keys + pos);
+    std::copy(leaf->entries + pos + 1, leaf->entries + leaf->size, leaf->entries + pos);
+    --leaf->size;
+    this->update_counts(leaf, -1);
+    this->entry_pool.destroy(entry);
+    --this->count;
+    Py_XDECREF(this->rebalance_leaf(leaf));
+}
+
+/**
+ * Erase the key-value pairs in a range. Do not update the reference counts of
+ * their keys and values. Those in the same leaf are erased together, so this
+ * takes time linear in their number plus logarithmic in the size of the tree
+ * per leaf visited.
+ *
+ * @param first Position of the first key-value pair.
+ * @param last Position just after the last key-value pair. Must not precede
+ * the first position.
+ */
+void SortedDictTree::erase(iterator first, iterator last)
+{
+    std::size_t remaining = this->rank(last) - this->rank(first);
+    SortedDictTreeEntry* entry = first.entry;
+    while (remaining > 0)
+    {
+        SortedDictTreeLeaf* leaf = entry->leaf;
+        unsigned short pos = leaf->index_of(entry);
+        unsigned short erased = std::min<std::size_t>(leaf->size - pos, remaining);
+        unsigned short end = pos + erased;
+
+        // Rebalancing may move the key-value pair just after the erased ones
+        // to another leaf, but it cannot erase it, so resume from it.
+        entry = end < leaf->size ? leaf->entries[end] : leaf->next == nullptr ? nullptr : leaf->next->entries[0];
+        for (unsigned short i = pos; i < end; ++i)
+        {
+            this->entry_pool.destroy(leaf->entries[i]);
+        }
+        std::copy(leaf->keys + end, leaf->keys + leaf->size, leaf->keys + pos);
+        std::copy(leaf->entries + end, leaf->entries + leaf->size, leaf->entries + pos);
+        leaf->size -= erased;
+        this->update_counts(leaf, -erased);
+        this->count -= erased;
+        remaining -= erased;
+        Py_XDECREF(this->rebalance_leaf(leaf));
+    }
+}
+
+/**
+ * Erase all key-value pairs. Do not update the reference counts of their keys
+ * and values.
+ */
+void SortedDictTree::clear(void)
+{
+    this->destroy();
+    this->root = this->first_leaf = this->last_leaf = this->new_leaf();
+    this->count = 0;
+}
+
+/**
+ * Record that the given copy of this tree replaced it. Move the references to
+ * key-value pairs held by iterators over this tree to their copies, and
+ * remember those pairs, so that the iterators can be moved later.
+ *
+ * @param successor Copy.
+ */
+void SortedDictTree::retire(SortedDictTree* successor)
+{
+    this->successor = successor;
+    for (iterator it = this->begin(), it_successor = successor->begin(); it != this->end(); ++it, ++it_successor)
+    {
+        if (it->second.known_referrers != 0)
+        {
+            it_successor->second.known_referrers = it->second.known_referrers;
+            this->forwards.emplace_back(&*it, &*it_successor);
+        }
+    }
+    std::sort(
+        this->forwards.begin(), this->forwards.end(),
+        [](auto const& a, auto const& b)
+        {
+            return std::less<SortedDictTreeEntry*>()(a.first, b.first);
+        }
+    );
+}
+
+/**
+ * Move an iterator over a tree which this tree replaced (directly or through
+ * other trees) to this tree. An iterator over this tree is returned as is.
+ *
+ * @param it Iterator. Must reference a key-value pair which was referenced by
+ *        some iterator when its tree was replaced, or be an end iterator.
+ *
+ * @return Iterator referencing the copy of the key-value pair.
+ */
+SortedDictTree::iterator SortedDictTree::follow(iterator it) const
+{
+    while (it.tree != this)
+    {
+        SortedDictTree const* tree = it.tree;
+        if (it.entry != nullptr)
+        {
+            auto forward = std::lower_bound(
+                tree->forwards.begin(), tree->forwards.end(), it.entry,
+                [](auto const& forward, SortedDictTreeEntry* entry)
+                {
+                    return std::less<SortedDictTreeEntry*>()(forward.first, entry);
+                }
+            );
+            it.entry = forward->second;
+        }
+        it.tree = tree->successor;
+    }
+    return it;
+}
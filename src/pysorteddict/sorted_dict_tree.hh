@@ -0,0 +1,634 @@
+#ifndef SORTED_DICT_TREE_HH_
+#define SORTED_DICT_TREE_HH_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sorted_dict_module.hh"
+
+/**
+ * Key stored in a sorted dictionary. For some key types, an unboxed copy of
+ * the key is stored alongside the Python object, so that two keys can be
+ * compared without calling into Python.
+ */
+struct SortedDictKey
+{
+public:
+    enum class Kind : unsigned char
+    {
+        // Compare the Python objects.
+        OBJECT,
+
+        // Compare the unboxed floating-point numbers.
+        DOUBLE,
+
+        // Compare the unboxed integers. Used only if the integer fits.
+        INT64,
+
+        // Compare the abbreviated keys of the strings, and then, if they are
+        // equal, the code points of the strings.
+        UNICODE,
+
+        // Compare the abbreviated keys of the byte strings, and then, if they
+        // are equal, the bytes of the byte strings.
+        BYTES,
+
+        // Compare the unboxed 128-bit unsigned integers. Used for keys (such
+        // as UUIDs and IPv6 addresses) which are ordered by such an integer.
+        UINT128,
+
+        // Compare the elements of the tuples one by one.
+        TUPLE,
+    };
+
+public:
+    PyObject* ob;
+    Kind kind;
+    union
+    {
+        double d;
+        long long ll;
+
+        // Abbreviated key: the first few bytes of the key (of its UTF-8
+        // encoding, if it is a string) as a big-endian integer, so that
+        // unequal abbreviated keys are ordered like the keys.
+        unsigned long long abbrev;
+        struct
+        {
+            unsigned long long hi;
+            unsigned long long lo;
+        } u128;
+    } native;
+
+public:
+    SortedDictKey(void) = default;
+
+    SortedDictKey(PyObject* ob, SortedDictModuleState* state) : ob(ob), kind(Kind::OBJECT), native { .ll = 0 }
+    {
+        // The key type is checked before a key is constructed, and only
+        // instances of exactly that type are accepted. Hence, exact checks
+        // suffice.
+        if (PyFloat_CheckExact(ob))
+        {
+            this->kind = Kind::DOUBLE;
+            this->native.d = PyFloat_AS_DOUBLE(ob);
+        }
+        else if (PyLong_CheckExact(ob))
+        {
+            int overflow;
+            long long ll = PyLong_AsLongLongAndOverflow(ob, &overflow);
+            if (overflow == 0)
+            {
+                this->kind = Kind::INT64;
+                this->native.ll = ll;
+            }
+        }
+        else if (PyBool_Check(ob))
+        {
+            this->kind = Kind::INT64;
+            this->native.ll = Py_IsTrue(ob);
+        }
+        else if (PyUnicode_CheckExact(ob))
+        {
+            this->kind = Kind::UNICODE;
+            this->native.abbrev = abbreviate_unicode(ob);
+        }
+        else if (PyBytes_CheckExact(ob))
+        {
+            this->kind = Kind::BYTES;
+            this->native.abbrev = abbreviate(PyBytes_AS_STRING(ob), PyBytes_GET_SIZE(ob));
+        }
+        else if (PyTuple_CheckExact(ob))
+        {
+            this->kind = Kind::TUPLE;
+        }
+        else
+        {
+            this->unbox(state);
+        }
+    }
+
+private:
+    void unbox(SortedDictModuleState*);
+    static unsigned long long abbreviate_unicode(PyObject*);
+
+    /**
+     * Abbreviate a byte string. If it is shorter than the abbreviated key,
+     * pad it with zeros. Hence, two byte strings may have equal abbreviated
+     * keys even if they differ in their first few bytes.
+     *
+     * @param buf Bytes.
+     * @param size Number of bytes.
+     *
+     * @return Abbreviated key.
+     */
+    static unsigned long long abbreviate(char const* buf, Py_ssize_t size)
+    {
+        unsigned long long abbrev = 0;
+        for (Py_ssize_t i = 0; i < Py_ssize_t(sizeof abbrev); ++i)
+        {
+            abbrev = abbrev << 8 | (i < size ? static_cast<unsigned char>(buf[i]) : 0);
+        }
+        return abbrev;
+    }
+};
+
+/**
+ * C++-style comparison implementation for keys.
+ */
+struct SortedDictKeyCompare
+{
+    bool operator()(SortedDictKey const& a, SortedDictKey const& b) const
+    {
+        // Keys of the same type may still be of different kinds: an integer
+        // which does not fit in 64 bits is not unboxed.
+        if (a.kind == b.kind)
+        {
+            switch (a.kind)
+            {
+            case SortedDictKey::Kind::DOUBLE:
+                return a.native.d < b.native.d;
+            case SortedDictKey::Kind::INT64:
+                return a.native.ll < b.native.ll;
+            case SortedDictKey::Kind::UNICODE:
+                if (a.native.abbrev != b.native.abbrev)
+                {
+                    return a.native.abbrev < b.native.abbrev;
+                }
+                // Comparing two strings cannot fail.
+                return PyUnicode_Compare(a.ob, b.ob) < 0;
+            case SortedDictKey::Kind::BYTES:
+                if (a.native.abbrev != b.native.abbrev)
+                {
+                    return a.native.abbrev < b.native.abbrev;
+                }
+                return compare_bytes(a.ob, b.ob) < 0;
+            case SortedDictKey::Kind::UINT128:
+                return a.native.u128.hi < b.native.u128.hi
+                    || (a.native.u128.hi == b.native.u128.hi && a.native.u128.lo < b.native.u128.lo);
+            case SortedDictKey::Kind::TUPLE:
+                return compare_tuples(a.ob, b.ob) < 0;
+            default:
+                break;
+            }
+        }
+
+        // There must exist a total order on the set of possible keys. (Else,
+        // this comparison may error out.) Hence, only instances of the type
+        // of the first key inserted may be used as keys. (Instances of types
+        // derived from that type are not allowed, because comparisons between
+        // them can be customised to error out. Check the code to see how this
+        // is enforced.) With these precautions, this comparison should always
+        // work.
+        return PyObject_RichCompareBool(a.ob, b.ob, Py_LT) == 1;
+    }
+
+    static int compare_bytes(PyObject* a, PyObject* b)
+    {
+        Py_ssize_t a_size = PyBytes_GET_SIZE(a);
+        Py_ssize_t b_size = PyBytes_GET_SIZE(b);
+        int result = std::memcmp(PyBytes_AS_STRING(a), PyBytes_AS_STRING(b), std::min(a_size, b_size));
+        if (result != 0)
+        {
+            return result;
+        }
+        return (a_size > b_size) - (a_size < b_size);
+    }
+
+    static int compare_tuples(PyObject*, PyObject*);
+};
+
+struct SortedDictValue
+{
+public:
+    PyObject* value;
+
+    // Number of objects which require access to the key-value pair this value
+    // is part of. They will all hold references to the containing sorted
+    // dictionary.
+    Py_ssize_t known_referrers;
+
+public:
+    SortedDictValue(PyObject* value) : value(value), known_referrers(0)
+    {
+    }
+};
+
+
+struct SortedDictTreeLeaf;
+struct SortedDictTreeInternal;
+class SortedDictTree;
+
+/**
+ * Key-value pair stored in a sorted dictionary. It is allocated separately
+ * from the tree nodes, so that its address does not change when the tree is
+ * rebalanced. That is what keeps iterators valid across insertions and
+ * erasures of other key-value pairs, like those of `std::map`.
+ */
+struct SortedDictTreeEntry
+{
+public:
+    SortedDictKey first;
+    SortedDictValue second;
+
+    // Leaf containing this key-value pair.
+    SortedDictTreeLeaf* leaf;
+
+    // Key as inserted. If the sorted dictionary has a key function, the key
+    // in `first` is the sort key derived from this, and this holds a separate
+    // reference unless they are the same object. Else, they are always the
+    // same object.
+    PyObject* key;
+
+public:
+    SortedDictTreeEntry(SortedDictKey const& first, PyObject* key, PyObject* second) :
+        first(first), second(second), leaf(nullptr), key(key)
+    {
+    }
+};
+
+// Maximum number of keys in a leaf and of children of an internal node.
+constexpr unsigned short SORTED_DICT_TREE_WIDTH = 32;
+
+// Nodes with fewer keys or children than this are rebalanced. Much smaller
+// than half the width, so that alternately inserting and erasing the same key
+// does not repeatedly split and merge the same nodes.
+constexpr unsigned short SORTED_DICT_TREE_MIN_WIDTH = SORTED_DICT_TREE_WIDTH / 4;
+
+// Number of keys in a leaf and of children of an internal node when a tree is
+// built in bulk. Leaves some room for insertions.
+constexpr unsigned short SORTED_DICT_TREE_BULK_WIDTH = SORTED_DICT_TREE_WIDTH - SORTED_DICT_TREE_WIDTH / 4;
+
+struct SortedDictTreeNode
+{
+public:
+    SortedDictTreeInternal* parent;
+
+    // Position of this node among the children of its parent.
+    unsigned short slot;
+
+    // Number of keys (if this is a leaf) or children (if this is an internal
+    // node).
+    unsigned short size;
+
+    bool is_leaf;
+};
+
+struct SortedDictTreeLeaf : public SortedDictTreeNode
+{
+public:
+    SortedDictTreeLeaf* prev;
+    SortedDictTreeLeaf* next;
+
+    // Copies of the keys of the key-value pairs, so that a search does not
+    // have to visit them. These do not own references.
+    SortedDictKey keys[SORTED_DICT_TREE_WIDTH];
+    SortedDictTreeEntry* entries[SORTED_DICT_TREE_WIDTH];
+
+public:
+    unsigned short index_of(SortedDictTreeEntry* entry) const
+    {
+        return std::find(this->entries, this->entries + this->size, entry) - this->entries;
+    }
+};
+
+struct SortedDictTreeInternal : public SortedDictTreeNode
+{
+public:
+    // The key at position `i` is less than or equal to every key in the
+    // subtree rooted at the child at position `i + 1`, and greater than every
+    // key in the subtree rooted at the child at position `i`. It may no
+    // longer be present in the tree, so these own references.
+    SortedDictKey keys[SORTED_DICT_TREE_WIDTH - 1];
+    SortedDictTreeNode* children[SORTED_DICT_TREE_WIDTH];
+
+    // Number of key-value pairs in the subtree rooted at each child. These
+    // make it possible to find a key-value pair by its position (and vice
+    // versa) in logarithmic time.
+    std::size_t counts[SORTED_DICT_TREE_WIDTH];
+};
+
+/**
+ * Bidirectional iterator over the key-value pairs in a tree. The end iterator
+ * does not point to any key-value pair.
+ */
+class SortedDictTreeIterator
+{
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = SortedDictTreeEntry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = SortedDictTreeEntry*;
+    using reference = SortedDictTreeEntry&;
+
+private:
+    SortedDictTree const* tree;
+    SortedDictTreeEntry* entry;
+
+public:
+    SortedDictTreeIterator(void) : tree(nullptr), entry(nullptr)
+    {
+    }
+
+    SortedDictTreeIterator(SortedDictTree const* tree, SortedDictTreeEntry* entry) : tree(tree), entry(entry)
+    {
+    }
+
+    reference operator*(void) const
+    {
+        return *this->entry;
+    }
+
+    pointer operator->(void) const
+    {
+        return this->entry;
+    }
+
+    SortedDictTreeIterator& operator++(void);
+    SortedDictTreeIterator& operator--(void);
+
+    SortedDictTreeIterator operator++(int)
+    {
+        SortedDictTreeIterator it = *this;
+        ++*this;
+        return it;
+    }
+
+    SortedDictTreeIterator operator--(int)
+    {
+        SortedDictTreeIterator it = *this;
+        --*this;
+        return it;
+    }
+
+    bool operator==(SortedDictTreeIterator const& that) const
+    {
+        return this->entry == that.entry;
+    }
+
+    friend class SortedDictTree;
+};
+
+/**
+ * Allocator which carves objects of one type out of large blocks of memory and
+ * recycles those released. The blocks are deallocated together when the pool
+ * is cleared, so the objects are never destructed.
+ */
+template<typename T>
+class SortedDictTreePool
+{
+    static_assert(std::is_trivially_destructible_v<T>);
+
+private:
+    // A released object is linked to the next one through its storage.
+    union Slot
+    {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // Each block is twice as large as the previous one, up to a limit, so
+    // that small trees do not hold much unused memory.
+    static constexpr std::size_t MAX_BLOCK_SIZE = 1024;
+
+    std::vector<Slot*> blocks;
+    std::size_t block_size;
+
+    // Unused part of the last block.
+    Slot* cursor;
+    Slot* limit;
+
+    Slot* released;
+
+public:
+    SortedDictTreePool(void) : block_size(0), cursor(nullptr), limit(nullptr), released(nullptr)
+    {
+    }
+
+    SortedDictTreePool(SortedDictTreePool const&) = delete;
+    SortedDictTreePool& operator=(SortedDictTreePool const&) = delete;
+
+    ~SortedDictTreePool(void)
+    {
+        this->clear();
+    }
+
+    template<typename... Args>
+    T* create(Args&&... args)
+    {
+        Slot* slot;
+        if (this->released != nullptr)
+        {
+            slot = this->released;
+            this->released = slot->next;
+        }
+        else
+        {
+            if (this->cursor == this->limit)
+            {
+                this->block_size = std::min(std::max(this->block_size * 2, std::size_t(1)), MAX_BLOCK_SIZE);
+                this->cursor = static_cast<Slot*>(::operator new(this->block_size * sizeof(Slot)));
+                this->limit = this->cursor + this->block_size;
+                this->blocks.push_back(this->cursor);
+            }
+            slot = this->cursor++;
+        }
+        if constexpr (sizeof...(Args) == 0)
+        {
+            return new (slot->storage) T;
+        }
+        else
+        {
+            return new (slot->storage) T(std::forward<Args>(args)...);
+        }
+    }
+
+    void destroy(T* ob)
+    {
+        Slot* slot = reinterpret_cast<Slot*>(ob);
+        slot->next = this->released;
+        this->released = slot;
+    }
+
+    void clear(void)
+    {
+        for (Slot* block : this->blocks)
+        {
+            ::operator delete(block);
+        }
+        this->blocks.clear();
+        this->block_size = 0;
+        this->cursor = this->limit = this->released = nullptr;
+    }
+};
+
+/**
+ * B+ tree of key-value pairs. Its interface is the subset of that of `std::map`
+ * which the sorted dictionary requires.
+ *
+ * Each node holds many keys in contiguous memory, so a search visits far fewer
+ * cache lines than it would in a red-black tree. The leaves are linked to
+ * their neighbours, so that iteration does not have to climb the tree. The
+ * internal nodes keep count of the key-value pairs under them, so that
+ * positional access does not have to iterate. The nodes and key-value pairs
+ * are allocated from pools owned by the tree, so that clearing it does not
+ * have to deallocate them one by one.
+ */
+class SortedDictTree
+{
+public:
+    using iterator = SortedDictTreeIterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+private:
+    SortedDictTreeNode* root;
+    SortedDictTreeLeaf* first_leaf;
+    SortedDictTreeLeaf* last_leaf;
+    std::size_t count;
+    SortedDictTreePool<SortedDictTreeEntry> entry_pool;
+    SortedDictTreePool<SortedDictTreeLeaf> leaf_pool;
+    SortedDictTreePool<SortedDictTreeInternal> internal_pool;
+
+    // Number of sorted dictionaries using this tree. Only one of them may
+    // modify it, and only after they stop sharing it.
+    std::atomic<std::size_t> owners;
+
+    // Tree which replaced this one in the sorted dictionary which may modify
+    // it, if any. Iterators over this tree are moved to that one using the
+    // key-value pairs they referenced and their copies, sorted by address.
+    SortedDictTree* successor;
+    std::vector<std::pair<SortedDictTreeEntry*, SortedDictTreeEntry*>> forwards;
+
+private:
+    SortedDictTreeLeaf* new_leaf(void);
+    SortedDictTreeInternal* new_internal(void);
+    void insert_into_leaf(SortedDictTreeLeaf*, unsigned short, SortedDictTreeEntry*);
+    void insert_into_parent(SortedDictTreeNode*, SortedDictKey const&, SortedDictTreeNode*);
+    SortedDictKey remove_from_parent(SortedDictTreeNode*);
+    PyObject* rebalance_leaf(SortedDictTreeLeaf*);
+    void rebalance_internal(SortedDictTreeInternal*);
+    void build(std::vector<SortedDictTreeEntry*> const&);
+    void release_separators(SortedDictTreeNode*);
+    void destroy(void);
+    static SortedDictKey const& lower_separator(SortedDictTreeNode*);
+    static std::size_t count_of(SortedDictTreeNode*);
+    static void update_counts(SortedDictTreeNode*, std::ptrdiff_t);
+
+public:
+    SortedDictTree(void);
+    SortedDictTree(SortedDictTree const&);
+    SortedDictTree& operator=(SortedDictTree const&) = delete;
+    ~SortedDictTree(void);
+
+    iterator begin(void) const
+    {
+        return { this, this->count == 0 ? nullptr : this->first_leaf->entries[0] };
+    }
+
+    iterator end(void) const
+    {
+        return { this, nullptr };
+    }
+
+    reverse_iterator rbegin(void) const
+    {
+        return reverse_iterator(this->end());
+    }
+
+    reverse_iterator rend(void) const
+    {
+        return reverse_iterator(this->begin());
+    }
+
+    std::size_t size(void) const
+    {
+        return this->count;
+    }
+
+    SortedDictKeyCompare key_comp(void) const
+    {
+        return {};
+    }
+
+    iterator lower_bound(SortedDictKey const&) const;
+    iterator nth(std::size_t) const;
+    std::size_t rank(iterator) const;
+    iterator advance(iterator, std::ptrdiff_t) const;
+    iterator emplace_hint(iterator, SortedDictKey const&, PyObject*, PyObject*);
+    void assign(std::vector<SortedDictTreeEntry> const&);
+    void erase(iterator);
+    void erase(iterator, iterator);
+    void clear(void);
+
+    void acquire(void)
+    {
+        ++this->owners;
+    }
+
+    bool release(void)
+    {
+        return --this->owners == 0;
+    }
+
+    bool is_shared(void) const
+    {
+        return this->owners > 1;
+    }
+
+    SortedDictTree* get_successor(void) const
+    {
+        return this->successor;
+    }
+
+    void retire(SortedDictTree*);
+    iterator follow(iterator) const;
+
+    friend class SortedDictTreeIterator;
+};
+
+inline SortedDictTreeIterator& SortedDictTreeIterator::operator++(void)
+{
+    SortedDictTreeLeaf* leaf = this->entry->leaf;
+    unsigned short idx = leaf->index_of(this->entry) + 1;
+    if (idx < leaf->size)
+    {
+        this->entry = leaf->entries[idx];
+    }
+    else
+    {
+        this->entry = leaf->next == nullptr ? nullptr : leaf->next->entries[0];
+    }
+    return *this;
+}
+
+inline SortedDictTreeIterator& SortedDictTreeIterator::operator--(void)
+{
+    if (this->entry == nullptr)
+    {
+        SortedDictTreeLeaf* leaf = this->tree->last_leaf;
+        this->entry = leaf->entries[leaf->size - 1];
+        return *this;
+    }
+    SortedDictTreeLeaf* leaf = this->entry->leaf;
+    unsigned short idx = leaf->index_of(this->entry);
+    if (idx > 0)
+    {
+        this->entry = leaf->entries[idx - 1];
+    }
+    else
+    {
+        this->entry = leaf->prev->entries[leaf->prev->size - 1];
+    }
+    return *this;
+}
+
+#endif
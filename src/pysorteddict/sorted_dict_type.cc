@@ -1,9 +1,13 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <map>
 #include <string>
+#include <tuple>
 #include <utility>
 
 #include "sorted_dict_items_type.hh"
@@ -44,69 +48,229 @@ static PyTypeObject* import_python_type(char const* module_name, char const* typ
     return reinterpret_cast<PyTypeObject*>(type_ob);
 }
 
-// Key types which have to be imported explicitly using the above function.
-static PyTypeObject* PyDate_Type;
-static PyTypeObject* PyTimeDelta_Type;
-static PyTypeObject* PyDecimal_Type;
-static PyTypeObject* PyFraction_Type;
-static PyTypeObject* PyIPv4Address_Type;
-static PyTypeObject* PyIPv4Interface_Type;
-static PyTypeObject* PyIPv4Network_Type;
-static PyTypeObject* PyIPv6Address_Type;
-static PyTypeObject* PyIPv6Interface_Type;
-static PyTypeObject* PyIPv6Network_Type;
-static PyTypeObject* PyPosixPath_Type;
-static PyTypeObject* PyPurePosixPath_Type;
-static PyTypeObject* PyPureWindowsPath_Type;
-static PyTypeObject* PyWindowsPath_Type;
-static PyTypeObject* PyStructTime_Type;
-static PyTypeObject* PyUUID_Type;
+/**
+ * Import the C API of the `datetime` module into the module state. It is
+ * unavailable if the pure-Python implementation of that module is used or if
+ * the module is shadowed; dates and time deltas are then not unboxed, because
+ * they must not be read as C structures.
+ *
+ * @param state Module state.
+ */
+static void import_datetime_capi(SortedDictModuleState* state)
+{
+    PyErrorClearer _;
+    state->datetime_capi = nullptr;
+    PyObjectWrapper module_ob(PyImport_ImportModule("datetime"));  // 🆕
+    if (module_ob == nullptr)
+    {
+        return;
+    }
+    Py_XSETREF(state->datetime_capsule, PyObject_GetAttrString(module_ob.get(), "datetime_CAPI"));  // 🆕
+    if (state->datetime_capsule == nullptr)
+    {
+        return;
+    }
+    void* datetime_capi = PyCapsule_GetPointer(state->datetime_capsule, PyDateTime_CAPSULE_NAME);
+    state->datetime_capi = static_cast<PyDateTime_CAPI*>(datetime_capi);
+}
 
 /**
- * Try to set the key type of the sorted dictionary. It should not already be
- * set. The provided argument should not be a null pointer.
+ * Import the key types which are not built-in into the module state, unless
+ * already done.
+ *
+ * This can't be done by initialising a static local variable. Importing runs
+ * Python code, during which another thread may try to initialise the same
+ * variable, and wait indefinitely for this thread while blocking it.
+ *
+ * @param state Module state.
+ */
+static void import_key_types(SortedDictModuleState* state)
+{
+#ifdef Py_GIL_DISABLED
+    // Unlike a C++ mutex, this allows other threads to run Python code while
+    // this thread waits.
+    PyMutex_Lock(&state->key_types_mutex);
+#endif
+    // With the GIL, another thread may import concurrently, but it will get
+    // the same types.
+    if (!state->key_types_imported)
+    {
+        Py_XSETREF(state->PyDate_Type, import_python_type("datetime", "date"));
+        Py_XSETREF(state->PyTimeDelta_Type, import_python_type("datetime", "timedelta"));
+        Py_XSETREF(state->PyDecimal_Type, import_python_type("decimal", "Decimal"));
+        Py_XSETREF(state->PyFraction_Type, import_python_type("fractions", "Fraction"));
+        Py_XSETREF(state->PyIPv4Address_Type, import_python_type("ipaddress", "IPv4Address"));
+        Py_XSETREF(state->PyIPv4Interface_Type, import_python_type("ipaddress", "IPv4Interface"));
+        Py_XSETREF(state->PyIPv4Network_Type, import_python_type("ipaddress", "IPv4Network"));
+        Py_XSETREF(state->PyIPv6Address_Type, import_python_type("ipaddress", "IPv6Address"));
+        Py_XSETREF(state->PyIPv6Interface_Type, import_python_type("ipaddress", "IPv6Interface"));
+        Py_XSETREF(state->PyIPv6Network_Type, import_python_type("ipaddress", "IPv6Network"));
+        Py_XSETREF(state->PyPosixPath_Type, import_python_type("pathlib", "PosixPath"));
+        Py_XSETREF(state->PyPurePosixPath_Type, import_python_type("pathlib", "PurePosixPath"));
+        Py_XSETREF(state->PyPureWindowsPath_Type, import_python_type("pathlib", "PureWindowsPath"));
+        Py_XSETREF(state->PyWindowsPath_Type, import_python_type("pathlib", "WindowsPath"));
+        Py_XSETREF(state->PyStructTime_Type, import_python_type("time", "struct_time"));
+        Py_XSETREF(state->PyUUID_Type, import_python_type("uuid", "UUID"));
+        import_datetime_capi(state);
+        state->key_types_imported = true;
+    }
+#ifdef Py_GIL_DISABLED
+    PyMutex_Unlock(&state->key_types_mutex);
+#endif
+}
+
+/**
+ * Check whether the given type is a supported key type other than `tuple`,
+ * i.e. whether it can also be the type of an element of a tuple key.
  *
  * @param key_type Key type.
+ * @param state Module state.
  *
- * @return `true` if successful, else `false`.
+ * @return `true` if it is supported, else `false`.
  */
-bool SortedDictType::try_set_key_type(PyObject* key_type)
+static bool is_key_type_supported(PyObject* key_type, SortedDictModuleState* state)
 {
-    static PyTypeObject* allowed_key_types[] = {
+    import_key_types(state);
+    PyTypeObject* allowed_key_types[] = {
         &PyBool_Type,
         &PyBytes_Type,
         &PyFloat_Type,
         &PyLong_Type,
         &PyUnicode_Type,
         // The following types are not built-in.
-        PyDate_Type = import_python_type("datetime", "date"),
-        PyTimeDelta_Type = import_python_type("datetime", "timedelta"),
-        PyDecimal_Type = import_python_type("decimal", "Decimal"),
-        PyFraction_Type = import_python_type("fractions", "Fraction"),
-        PyIPv4Address_Type = import_python_type("ipaddress", "IPv4Address"),
-        PyIPv4Interface_Type = import_python_type("ipaddress", "IPv4Interface"),
-        PyIPv4Network_Type = import_python_type("ipaddress", "IPv4Network"),
-        PyIPv6Address_Type = import_python_type("ipaddress", "IPv6Address"),
-        PyIPv6Interface_Type = import_python_type("ipaddress", "IPv6Interface"),
-        PyIPv6Network_Type = import_python_type("ipaddress", "IPv6Network"),
-        PyPosixPath_Type = import_python_type("pathlib", "PosixPath"),
-        PyPurePosixPath_Type = import_python_type("pathlib", "PurePosixPath"),
-        PyPureWindowsPath_Type = import_python_type("pathlib", "PureWindowsPath"),
-        PyWindowsPath_Type = import_python_type("pathlib", "WindowsPath"),
-        PyStructTime_Type = import_python_type("time", "struct_time"),
-        PyUUID_Type = import_python_type("uuid", "UUID"),
+        state->PyDate_Type,
+        state->PyTimeDelta_Type,
+        state->PyDecimal_Type,
+        state->PyFraction_Type,
+        state->PyIPv4Address_Type,
+        state->PyIPv4Interface_Type,
+        state->PyIPv4Network_Type,
+        state->PyIPv6Address_Type,
+        state->PyIPv6Interface_Type,
+        state->PyIPv6Network_Type,
+        state->PyPosixPath_Type,
+        state->PyPurePosixPath_Type,
+        state->PyPureWindowsPath_Type,
+        state->PyWindowsPath_Type,
+        state->PyStructTime_Type,
+        state->PyUUID_Type,
     };
     for (PyTypeObject* allowed_key_type : allowed_key_types)
     {
         if (allowed_key_type != nullptr && Py_Is(key_type, reinterpret_cast<PyObject*>(allowed_key_type)))
         {
-            this->key_type = allowed_key_type;
             return true;
         }
     }
     return false;
 }
 
+/**
+ * Try to set the key type of the sorted dictionary. It should not already be
+ * set. The provided argument should not be a null pointer.
+ *
+ * @param key_type Key type.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::try_set_key_type(PyObject* key_type)
+{
+    if (!Py_Is(key_type, reinterpret_cast<PyObject*>(&PyTuple_Type)) && !is_key_type_supported(key_type, this->state))
+    {
+        return false;
+    }
+    this->key_type = reinterpret_cast<PyTypeObject*>(key_type);
+    return true;
+}
+
+/**
+ * Obtain the types of the elements of the given tuple.
+ *
+ * @param key Tuple.
+ *
+ * @return Tuple of types if successful, else `nullptr`.
+ */
+static PyObject* element_types_of(PyObject* key)
+{
+    Py_ssize_t sz = PyTuple_GET_SIZE(key);
+    PyObject* element_types = PyTuple_New(sz);  // 🆕
+    if (element_types == nullptr)
+    {
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < sz; ++i)
+    {
+        PyTuple_SET_ITEM(element_types, i, Py_NewRef(Py_TYPE(PyTuple_GET_ITEM(key, i))));  // 🆕
+    }
+    return element_types;
+}
+
+/**
+ * Try to set the element types of the tuple keys of the sorted dictionary to
+ * those of the elements of the given tuple key. They should not already be
+ * set. On failure, set a Python exception.
+ *
+ * @param key Key. Must be a tuple.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::try_set_key_element_types(PyObject* key)
+{
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(key); ++i)
+    {
+        PyObject* element = PyTuple_GET_ITEM(key, i);
+        PyObject* element_type = reinterpret_cast<PyObject*>(Py_TYPE(element));
+        if (!is_key_type_supported(element_type, this->state))
+        {
+            PyErr_Format(
+                PyExc_TypeError, "got key %R with element %R of unsupported type %R", key, element, element_type
+            );
+            return false;
+        }
+    }
+    this->key_element_types = element_types_of(key);  // 🆕
+    return this->key_element_types != nullptr;
+}
+
+/**
+ * Check whether the elements of the given tuple key are of the element types
+ * of the tuple keys of a sorted dictionary. On failure, set a Python
+ * exception.
+ *
+ * @param key Key. Must be a tuple.
+ * @param key_element_types Element types, or `nullptr` if they are not set.
+ *
+ * @return `true` if the check succeeds, else `false`.
+ */
+bool SortedDictType::are_key_elements_good(PyObject* key, PyObject* key_element_types)
+{
+    if (key_element_types == nullptr)
+    {
+        // No tuple keys have been inserted, so there is nothing to compare
+        // this one with.
+        return true;
+    }
+    Py_ssize_t sz = PyTuple_GET_SIZE(key);
+    bool good = sz == PyTuple_GET_SIZE(key_element_types);
+    for (Py_ssize_t i = 0; good && i < sz; ++i)
+    {
+        PyObject* element_type = PyTuple_GET_ITEM(key_element_types, i);
+        good = Py_IS_TYPE(PyTuple_GET_ITEM(key, i), reinterpret_cast<PyTypeObject*>(element_type));
+    }
+    if (!good)
+    {
+        PyObjectWrapper element_types(element_types_of(key));  // 🆕
+        if (element_types != nullptr)
+        {
+            PyErr_Format(
+                PyExc_TypeError, "got key %R with element types %R, want key with element types %R", key,
+                element_types.get(), key_element_types
+            );
+        }
+    }
+    return good;
+}
+
 /**
  * Check whether the given key can be inserted into this sorted dictionary. For
  * instance, NaN cannot be compared with other floating-point numbers, so it
@@ -121,11 +285,39 @@ bool SortedDictType::try_set_key_type(PyObject* key_type)
  */
 bool SortedDictType::is_key_good(PyObject* key)
 {
-    if (this->key_type == &PyFloat_Type)
+    return is_key_good(key, this->key_type, this->state);
+}
+
+/**
+ * Check whether the given key of the given key type can be compared with other
+ * keys of that type. See above.
+ *
+ * @param key Key.
+ * @param key_type Key type. Must be the type of the key.
+ * @param state Module state.
+ *
+ * @return `true` if the check succeeds, else `false`.
+ */
+bool SortedDictType::is_key_good(PyObject* key, PyTypeObject* key_type, SortedDictModuleState* state)
+{
+    if (key_type == &PyFloat_Type)
     {
         return !std::isnan(PyFloat_AS_DOUBLE(key));
     }
-    if (this->key_type == PyDecimal_Type)
+    if (key_type == &PyTuple_Type)
+    {
+        // The types of the elements are checked separately.
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(key); ++i)
+        {
+            PyObject* element = PyTuple_GET_ITEM(key, i);
+            if (!is_key_good(element, Py_TYPE(element), state))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (key_type == state->PyDecimal_Type)
     {
         PyErrorClearer _;
         PyObjectWrapper key_is_nan(PyObject_CallMethod(key, "is_nan", nullptr));  // 🆕
@@ -186,6 +378,29 @@ bool SortedDictType::are_key_type_and_key_value_pair_good(PyObject* key, PyObjec
         return false;
     }
 
+    // The elements of tuple keys must be of the same types as those of the
+    // first tuple key inserted. Else, they may not be comparable.
+    bool key_element_types_set_here = false;
+    if (this->key_type == &PyTuple_Type)
+    {
+        if (this->key_element_types == nullptr && value != nullptr)
+        {
+            key_element_types_set_here = this->try_set_key_element_types(key);
+            if (!key_element_types_set_here)
+            {
+                if (key_type_set_here)
+                {
+                    this->key_type = nullptr;
+                }
+                return false;
+            }
+        }
+        else if (!are_key_elements_good(key, this->key_element_types))
+        {
+            return false;
+        }
+    }
+
     // At this point, the key is guaranteed to be of the correct type. Hence,
     // it is safe to call this method.
     if (!this->is_key_good(key))
@@ -197,11 +412,119 @@ bool SortedDictType::are_key_type_and_key_value_pair_good(PyObject* key, PyObjec
             // key type.
             this->key_type = nullptr;
         }
+        if (key_element_types_set_here)
+        {
+            Py_CLEAR(this->key_element_types);
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Obtain the sort key of the given key: the result of calling the key function
+ * on it if there is one, else the key itself. Then check whether the key type
+ * and the sort key and the given value satisfy the conditions described above.
+ * On failure, set a Python exception.
+ *
+ * @param key Key.
+ * @param value Value.
+ *
+ * @return Sort key if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::sort_key_of(PyObject* key, PyObject* value)
+{
+    PyObjectWrapper sort_key(
+        this->key_func == nullptr ? Py_NewRef(key) : PyObject_CallOneArg(this->key_func, key)
+    );  // 🆕
+    if (sort_key == nullptr || !this->are_key_type_and_key_value_pair_good(sort_key.get(), value))
+    {
+        return nullptr;
+    }
+    return sort_key.release();
+}
+
+/**
+ * Check whether an object can be used as a key function. On failure, set a
+ * Python exception.
+ *
+ * @param key_func Key function, or `None`.
+ *
+ * @return `true` if it is `None` or callable, else `false`.
+ */
+static bool is_key_func_good(PyObject* key_func)
+{
+    if (!Py_IsNone(key_func) && !PyCallable_Check(key_func))
+    {
+        PyErr_Format(PyExc_TypeError, "got key function %R of type %R, want callable", key_func, Py_TYPE(key_func));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Set the key function of this sorted dictionary. It can be changed only while
+ * this sorted dictionary is empty. On failure, set a Python exception.
+ *
+ * @param key_func Key function, or `None` to remove it.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::set_key_func(PyObject* key_func)
+{
+    if (!is_key_func_good(key_func))
+    {
+        return false;
+    }
+    key_func = Py_IsNone(key_func) ? nullptr : key_func;
+    if (key_func == this->key_func)
+    {
+        return true;
+    }
+    if (!this->is_modification_allowed())
+    {
+        return false;
+    }
+    if (this->map->size() != 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "cannot change key function of non-empty sorted dictionary");
         return false;
     }
+    Py_XSETREF(this->key_func, Py_XNewRef(key_func));
     return true;
 }
 
+/**
+ * Acquire references to the key, the sort key (if it is a different object)
+ * and the value of a key-value pair.
+ *
+ * @param item Key-value pair.
+ */
+static void acquire_item(SortedDictTreeEntry const& item)
+{
+    Py_INCREF(item.first.ob);  // 🆕
+    if (item.key != item.first.ob)
+    {
+        Py_INCREF(item.key);  // 🆕
+    }
+    Py_INCREF(item.second.value);  // 🆕
+}
+
+/**
+ * Release the references acquired by the above function.
+ *
+ * @param item Key-value pair.
+ */
+static void release_item(SortedDictTreeEntry const& item)
+{
+    if (item.key != item.first.ob)
+    {
+        Py_DECREF(item.key);
+    }
+    Py_DECREF(item.first.ob);
+    Py_DECREF(item.second.value);
+}
+
 /**
  * Check whether every key-value pair in this sorted dictionary can be deleted.
  *
@@ -239,6 +562,115 @@ bool SortedDictType::is_deletion_allowed(Py_ssize_t kv_known_referrers)
     return true;
 }
 
+/**
+ * Check whether this sorted dictionary can be modified.
+ *
+ * @return `true` if the check succeeds, else `false`.
+ */
+bool SortedDictType::is_modification_allowed(void)
+{
+    if (this->is_snapshot)
+    {
+        PyErr_SetString(PyExc_TypeError, "operation not permitted: sorted dictionary is a snapshot");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Ensure that this sorted dictionary does not share its tree with a snapshot,
+ * so that the snapshot does not see the modification about to be made. This
+ * copies the tree, so it should be done only after everything which can fail
+ * has been checked.
+ */
+void SortedDictType::prepare_modification(void)
+{
+    if (this->map->is_shared())
+    {
+        this->unshare_map();
+    }
+}
+
+/**
+ * Ensure that this sorted dictionary does not share its tree with a snapshot,
+ * so that the snapshot does not see the modification about to be made.
+ *
+ * @param it Iterator into the tree.
+ *
+ * @return Iterator to the same position in the tree now used.
+ */
+FwdIterType SortedDictType::prepare_modification(FwdIterType it)
+{
+    if (!this->map->is_shared())
+    {
+        return it;
+    }
+    std::size_t pos = this->map->rank(it);
+    this->unshare_map();
+    return this->map->nth(pos);
+}
+
+/**
+ * Replace the tree of this sorted dictionary with a copy of it, leaving the
+ * original to the snapshots sharing it. Iterators over the original are moved
+ * to the copy when they are next used.
+ */
+void SortedDictType::unshare_map(void)
+{
+    SortedDictTree* map = new SortedDictTree(*this->map);
+    for (auto& item : *map)
+    {
+        acquire_item(item);
+    }
+    if (this->known_referrers == 0)
+    {
+        release_map(this->map);
+    }
+    else
+    {
+        this->map->retire(map);
+        if (this->retired_map == nullptr)
+        {
+            this->retired_map = this->map;
+        }
+    }
+    this->map = map;
+}
+
+/**
+ * Release the trees this sorted dictionary used before its current one. The
+ * caller should ensure that no iterators reference them.
+ */
+void SortedDictType::release_retired_maps(void)
+{
+    while (this->retired_map != nullptr && this->retired_map != this->map)
+    {
+        SortedDictTree* successor = this->retired_map->get_successor();
+        release_map(this->retired_map);
+        this->retired_map = successor;
+    }
+    this->retired_map = nullptr;
+}
+
+/**
+ * Stop using a tree. If no sorted dictionary uses it any longer, release the
+ * keys and values in it, and deallocate it.
+ *
+ * @param map Tree.
+ */
+void SortedDictType::release_map(SortedDictTree* map)
+{
+    if (!map->release())
+    {
+        return;
+    }
+    for (auto& item : *map)
+    {
+        release_item(item);
+    }
+    delete map;
+}
+
 /**
  * Check whether the number of arguments falls within the specified range.
  *
@@ -272,46 +704,288 @@ bool SortedDictType::is_nargs_good(char const* caller, Py_ssize_t nargs, int at_
  *
  * @return The lower bound of the given key and whether it was found.
  */
-std::pair<FwdIterType, bool> SortedDictType::try_find(PyObject* key)
+std::pair<FwdIterType, bool> SortedDictType::try_find(SortedDictKey const& key)
 {
     auto it = this->map->lower_bound(key);
     return { it, it != this->map->end() && !this->map->key_comp()(key, it->first) };
 }
 
 /**
- * Update the sorted dictionary with the keys and values from the given
- * mapping.
+ * Try to find the given good key. See above.
  *
- * @param mp Mapping.
+ * @param key Good key.
+ *
+ * @return The lower bound of the given key and whether it was found.
+ */
+std::pair<FwdIterType, bool> SortedDictType::try_find(PyObject* key)
+{
+    return this->try_find(SortedDictKey(key, this->state));
+}
+
+/**
+ * Parse the optional position argument of a method. On failure, set a Python
+ * exception.
+ *
+ * @param args Arguments.
+ * @param nargs Number of arguments.
+ * @param position Position. Set to -1 if no position is given.
  *
  * @return `true` if successful, else `false`.
  */
-bool SortedDictType::update_from_mapping(PyObject* mp)
+bool SortedDictType::parse_position(PyObject* const* args, Py_ssize_t nargs, Py_ssize_t& position)
 {
-    // The built-in dictionary in CPython creates a list of the keys and
-    // iterates over it. This differs from what the docstring claims: that it
-    // iterates over the mapping. That is functionally the same thing. (If not,
-    // the mapping is non-compliant.) I iterate over the mapping, since that
-    // avoids creating the list.
-    PyObjectWrapper keys_iter(PyObject_GetIter(mp));  // 🆕
-    if (keys_iter == nullptr)
+    position = -1;
+    if (nargs == 0)
     {
-        return false;
+        return true;
     }
-    while (true)
-    {
-        PyObjectWrapper key(PyIter_Next(keys_iter.get()));  // 🆕
-        if (key == nullptr)
-        {
-            // Was there an error or did I exhaust all elements?
-            return PyErr_Occurred() == nullptr;
+    position = PyNumber_AsSsize_t(args[0], PyExc_IndexError);
+    return position != -1 || PyErr_Occurred() == nullptr;
+}
+
+/**
+ * Find the key-value pair at a position. On failure, set a Python exception.
+ *
+ * The first and last key-value pairs are found in constant time; any other
+ * takes logarithmic time.
+ *
+ * @param position Position. May be negative, in which case it is counted from
+ * the end.
+ *
+ * @return Iterator to the key-value pair and whether the position was valid.
+ */
+std::pair<FwdIterType, bool> SortedDictType::try_nth(Py_ssize_t position)
+{
+    Py_ssize_t sz = this->len();
+    if (sz == -1)
+    {
+        return { this->map->end(), false };
+    }
+    Py_ssize_t positive_position = position >= 0 ? position : position + sz;
+    if (positive_position < 0 || sz <= positive_position)
+    {
+        PyErr_Format(PyExc_IndexError, "got invalid index %zd for sorted dictionary of length %zd", position, sz);
+        return { this->map->end(), false };
+    }
+    if (positive_position == 0)
+    {
+        return { this->map->begin(), true };
+    }
+    if (positive_position == sz - 1)
+    {
+        return { std::prev(this->map->end()), true };
+    }
+    return { this->map->nth(positive_position), true };
+}
+
+/**
+ * Find the key-value pair whose key is nearest to the given key in the given
+ * direction. On failure, set a Python exception.
+ *
+ * @param key Key.
+ * @param greater Whether to look for a key greater than the given key (as
+ * opposed to a key less than it).
+ * @param or_equal Whether the given key itself qualifies.
+ * @param item Whether to return the key-value pair (as opposed to the key).
+ *
+ * @return Key-value pair or key if found, `None` if not found, `nullptr` on
+ * failure.
+ */
+PyObject* SortedDictType::nearest(PyObject* key, bool greater, bool or_equal, bool item)
+{
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    if (greater)
+    {
+        if (found && !or_equal)
+        {
+            ++it;
+        }
+    }
+    else if (!found || !or_equal)
+    {
+        if (it == this->map->begin())
+        {
+            Py_RETURN_NONE;
+        }
+        --it;
+    }
+    if (it == this->map->end())
+    {
+        Py_RETURN_NONE;
+    }
+    if (item)
+    {
+        return PyTuple_Pack(2, it->key, it->second.value);  // 🆕
+    }
+    return Py_NewRef(it->key);  // 🆕
+}
+
+/**
+ * Check whether the given key-value pair can be inserted into this sorted
+ * dictionary, and if so, append it to the given buffer. On failure, set a
+ * Python exception.
+ *
+ * @param items Buffer. Owns references to the keys and values in it.
+ * @param key Key.
+ * @param value Value.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::buffer_item(std::vector<SortedDictTreeEntry>& items, PyObject* key, PyObject* value)
+{
+    PyObject* sort_key = this->sort_key_of(key, value);  // 🆕
+    if (sort_key == nullptr)
+    {
+        return false;
+    }
+    items.emplace_back(SortedDictKey(sort_key, this->state), key, Py_NewRef(value));  // 🆕
+    if (key != sort_key)
+    {
+        Py_INCREF(key);  // 🆕
+    }
+    return true;
+}
+
+/**
+ * Insert the key-value pairs in the given buffer into this sorted dictionary.
+ * If a key occurs more than once, the value it is mapped to last wins.
+ *
+ * Releasing a key or value may run arbitrary Python code (e.g. `__del__`),
+ * which may modify this sorted dictionary. Hence, nothing is released while
+ * the tree is being read or modified.
+ *
+ * @param items Buffer. The references it owns are stolen. Its contents are
+ * unspecified afterwards.
+ */
+void SortedDictType::insert_items(std::vector<SortedDictTreeEntry>& items)
+{
+    auto comp = this->map->key_comp();
+    auto not_ascending = [&comp](auto const& a, auto const& b)
+    {
+        return !comp(a.first, b.first);
+    };
+
+    // Sort the key-value pairs unless they are already sorted (as they are
+    // when loading from a sorted source). A stable sort keeps those having
+    // equal keys in the order they were read in. Like a dictionary, keep the
+    // first of those keys (equal keys need not be identical: consider 0.0
+    // and -0.0) and the last of the values.
+    if (std::adjacent_find(items.begin(), items.end(), not_ascending) != items.end())
+    {
+        std::stable_sort(
+            items.begin(), items.end(),
+            [&comp](auto const& a, auto const& b)
+            {
+                return comp(a.first, b.first);
+            }
+        );
+        std::vector<SortedDictTreeEntry> released;
+        auto last = items.begin();
+        for (auto curr = items.begin(); curr != items.end(); ++curr)
+        {
+            if (last != items.begin() && not_ascending(*(last - 1), *curr))
+            {
+                std::swap((last - 1)->second.value, curr->second.value);
+                released.push_back(*curr);
+                continue;
+            }
+            *last++ = *curr;
+        }
+        items.erase(last, items.end());
+        for (auto& item : released)
+        {
+            release_item(item);
+        }
+    }
+
+    if (items.empty())
+    {
+        return;
+    }
+    this->prepare_modification();
+
+    // If this sorted dictionary is empty, the tree can be built bottom-up
+    // instead of one key at a time. This is checked only after the duplicates
+    // have been released, since that may have inserted keys.
+    if (this->map->size() == 0)
+    {
+        this->map->assign(items);
+        return;
+    }
+
+    // Merge the key-value pairs into the tree in a single sweep. The lower
+    // bound of each key is usually a short distance ahead of that of the
+    // previous key, so look for it there before searching from the root.
+    std::vector<SortedDictTreeEntry> released;
+    FwdIterType it = this->map->begin();
+    for (auto& item : items)
+    {
+        for (int steps = 0; it != this->map->end() && comp(it->first, item.first); ++steps)
+        {
+            if (steps == SORTED_DICT_TREE_WIDTH)
+            {
+                it = this->map->lower_bound(item.first);
+                break;
+            }
+            ++it;
+        }
+        if (it == this->map->end() || comp(item.first, it->first))
+        {
+            it = this->map->emplace_hint(it, item.first, item.key, item.second.value);
+        }
+        else
+        {
+            std::swap(it->second.value, item.second.value);
+            released.push_back(item);
+        }
+        ++it;
+    }
+    for (auto& item : released)
+    {
+        release_item(item);
+    }
+}
+
+/**
+ * Buffer the keys and values from the given mapping for insertion into this
+ * sorted dictionary.
+ *
+ * @param mp Mapping.
+ * @param items Buffer.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::update_from_mapping(PyObject* mp, std::vector<SortedDictTreeEntry>& items)
+{
+    // The built-in dictionary in CPython creates a list of the keys and
+    // iterates over it. This differs from what the docstring claims: that it
+    // iterates over the mapping. That is functionally the same thing. (If not,
+    // the mapping is non-compliant.) I iterate over the mapping, since that
+    // avoids creating the list.
+    PyObjectWrapper keys_iter(PyObject_GetIter(mp));  // 🆕
+    if (keys_iter == nullptr)
+    {
+        return false;
+    }
+    while (true)
+    {
+        PyObjectWrapper key(PyIter_Next(keys_iter.get()));  // 🆕
+        if (key == nullptr)
+        {
+            // Was there an error or did I exhaust all elements?
+            return PyErr_Occurred() == nullptr;
         }
         PyObjectWrapper value(PyObject_GetItem(mp, key.get()));  // 🆕
         if (value == nullptr)
         {
             return false;
         }
-        if (this->setitem(key.get(), value.get()) == -1)
+        if (!this->buffer_item(items, key.get(), value.get()))
         {
             return false;
         }
@@ -319,14 +993,15 @@ bool SortedDictType::update_from_mapping(PyObject* mp)
 }
 
 /**
- * Update the sorted dictionary with the keys and values from the given
- * sequence.
+ * Buffer the keys and values from the given sequence for insertion into this
+ * sorted dictionary.
  *
  * @param sq Sequence.
+ * @param items Buffer.
  *
  * @return `true` if successful, else `false`.
  */
-bool SortedDictType::update_from_sequence(PyObject* sq)
+bool SortedDictType::update_from_sequence(PyObject* sq, std::vector<SortedDictTreeEntry>& items)
 {
     PyObjectWrapper items_iter(PyObject_GetIter(sq));  // 🆕
     if (items_iter == nullptr)
@@ -358,11 +1033,150 @@ bool SortedDictType::update_from_sequence(PyObject* sq)
         }
         PyObject* key = PySequence_Fast_GET_ITEM(item_unpacked.get(), 0);
         PyObject* value = PySequence_Fast_GET_ITEM(item_unpacked.get(), 1);
-        if (this->setitem(key, value) == -1)
+        if (!this->buffer_item(items, key, value))
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * Remove the key-value pairs in a range from this sorted dictionary. On
+ * failure, set a Python exception.
+ *
+ * @param first Position of the first key-value pair.
+ * @param last Position just after the last key-value pair. Must not precede
+ * the first position.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::erase_range(FwdIterType first, FwdIterType last)
+{
+    // Check every key-value pair before removing any, so that none are
+    // removed on failure.
+    if (this->known_referrers != 0)
+    {
+        for (FwdIterType it = first; it != last; ++it)
+        {
+            if (!this->is_deletion_allowed(it->second.known_referrers))
+            {
+                return false;
+            }
+        }
+    }
+    if (this->map->is_shared())
+    {
+        std::ptrdiff_t distance = this->map->rank(last) - this->map->rank(first);
+        first = this->prepare_modification(first);
+        last = this->map->advance(first, distance);
+    }
+
+    // Releasing the keys and values may run arbitrary code, so do it only
+    // after the tree is consistent again.
+    std::vector<SortedDictTreeEntry> released(first, last);
+    this->map->erase(first, last);
+    for (auto& item : released)
+    {
+        release_item(item);
+    }
+    return true;
+}
+
+/**
+ * Buffer the keys and values from the given sorted dictionary for insertion
+ * into this sorted dictionary. They are buffered in ascending order of the
+ * keys, so that they can be merged into this sorted dictionary in one pass.
+ * The caller should hold a lock on it.
+ *
+ * @param that Sorted dictionary.
+ * @param items Buffer.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::update_from_sorted_dict(
+    SortedDictType* that, std::vector<SortedDictTreeEntry>& items
+)
+{
+    if (that == this)
+    {
+        // Nothing would change.
+        return true;
+    }
+    if (that->map->size() == 0)
+    {
+        return true;
+    }
+    if (that->key_func != this->key_func)
+    {
+        return this->update_from_sorted_dict_keys(that, items);
+    }
+
+    // The keys of the given sorted dictionary are good and of the same type,
+    // so if its first key passes the checks, the others will as well.
+    // Checking it may run Python code, so hold references to it.
+    PyObjectWrapper first_key(Py_NewRef(that->map->begin()->first.ob));  // 🆕
+    PyObjectWrapper first_value(Py_NewRef(that->map->begin()->second.value));  // 🆕
+    if (!this->are_key_type_and_key_value_pair_good(first_key.get(), first_value.get()))
+    {
+        return false;
+    }
+
+    // The given sorted dictionary may have changed while Python code was
+    // running, so its keys still have to be checked, though cheaply. If any
+    // of them is of a different type, check them all one at a time.
+    auto is_key_type_same = [this](auto const& item)
+    {
+        return Py_IS_TYPE(item.first.ob, this->key_type);
+    };
+    if (!std::all_of(that->map->begin(), that->map->end(), is_key_type_same))
+    {
+        return this->update_from_sorted_dict_keys(that, items);
+    }
+    items.reserve(that->map->size());
+    for (auto& item : *that->map)
+    {
+        acquire_item(item);
+        items.emplace_back(item.first, item.key, item.second.value);
+    }
+    return true;
+}
+
+/**
+ * Buffer the keys and values from the given sorted dictionary for insertion
+ * into this sorted dictionary, checking them one at a time (as is necessary
+ * if it has a different key function). The caller should hold a lock on it.
+ *
+ * @param that Sorted dictionary.
+ * @param items Buffer.
+ *
+ * @return `true` if successful, else `false`.
+ */
+bool SortedDictType::update_from_sorted_dict_keys(SortedDictType* that, std::vector<SortedDictTreeEntry>& items)
+{
+    // Obtaining the sort keys runs Python code, which may modify the given
+    // sorted dictionary, so copy its keys and values first.
+    Py_ssize_t sz = that->map->size();
+    PyObjectWrapper keys(PyList_New(sz));  // 🆕
+    PyObjectWrapper values(PyList_New(sz));  // 🆕
+    if (keys == nullptr || values == nullptr)
+    {
+        return false;
+    }
+    Py_ssize_t idx = 0;
+    for (auto& item : *that->map)
+    {
+        PyList_SET_ITEM(keys.get(), idx, Py_NewRef(item.key));  // 🆕
+        PyList_SET_ITEM(values.get(), idx++, Py_NewRef(item.second.value));  // 🆕
+    }
+    items.reserve(sz);
+    for (idx = 0; idx < sz; ++idx)
+    {
+        if (!this->buffer_item(items, PyList_GET_ITEM(keys.get(), idx), PyList_GET_ITEM(values.get(), idx)))
         {
             return false;
         }
     }
+    return true;
 }
 
 /**
@@ -374,12 +1188,24 @@ bool SortedDictType::update_from_sequence(PyObject* sq)
  */
 bool SortedDictType::update_from_object(PyObject* ob)
 {
-    return PyObject_HasAttrString(ob, "keys") ? this->update_from_mapping(ob) : this->update_from_sequence(ob);
+    std::vector<SortedDictTreeEntry> items;
+    bool success = PyObject_TypeCheck(ob, this->state->sorted_dict_type)
+        ? this->update_from_sorted_dict(reinterpret_cast<SortedDictType*>(ob), items)
+        : PyObject_HasAttrString(ob, "keys") ? this->update_from_mapping(ob, items)
+                                             : this->update_from_sequence(ob, items);
+
+    // Even if unsuccessful, the key-value pairs read before the error are
+    // inserted, as if they had been inserted one at a time. Inserting them may
+    // require comparing keys in Python, which must not happen while an
+    // exception is pending.
+    PyErrorStasher _;
+    this->insert_items(items);
+    return success;
 }
 
 PyObject* SortedDictType::update_impl(PyObject* const* args, Py_ssize_t nargs)
 {
-    if (nargs == 1 && !this->update_from_object(args[0]))
+    if (nargs == 1 && (!this->is_modification_allowed() || !this->update_from_object(args[0])))
     {
         return nullptr;
     }
@@ -389,13 +1215,13 @@ PyObject* SortedDictType::update_impl(PyObject* const* args, Py_ssize_t nargs)
 void SortedDictType::Delete(PyObject* self)
 {
     SortedDictType* sd = reinterpret_cast<SortedDictType*>(self);
-    for (auto& item : *sd->map)
-    {
-        Py_DECREF(item.first);
-        Py_DECREF(item.second.value);
-    }
-    delete sd->map;
-    Py_TYPE(self)->tp_free(self);
+    sd->release_retired_maps();
+    release_map(sd->map);
+    Py_XDECREF(sd->key_element_types);
+    Py_XDECREF(sd->key_func);
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
 }
 
 PyObject* SortedDictType::repr(void)
@@ -405,7 +1231,7 @@ PyObject* SortedDictType::repr(void)
     std::string this_repr_utf8 = "SortedDict" LEFT_PARENTHESIS LEFT_CURLY_BRACKET;
     for (auto& item : *this->map)
     {
-        PyObjectWrapper key_repr(PyObject_Repr(item.first));  // 🆕
+        PyObjectWrapper key_repr(PyObject_Repr(item.key));  // 🆕
         if (key_repr == nullptr)
         {
             return nullptr;
@@ -439,11 +1265,12 @@ PyObject* SortedDictType::repr(void)
  */
 int SortedDictType::contains(PyObject* key, PyObject* value)
 {
-    if (!this->are_key_type_and_key_value_pair_good(key))
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
     {
         return -1;
     }
-    auto [it, found] = this->try_find(key);
+    auto [it, found] = this->try_find(sort_key.get());
     if (!found)
     {
         return 0;
@@ -474,11 +1301,12 @@ Py_ssize_t SortedDictType::len(void)
  */
 PyObject* SortedDictType::getitem(PyObject* key)
 {
-    if (!this->are_key_type_and_key_value_pair_good(key))
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
     {
         return nullptr;
     }
-    auto [it, found] = this->try_find(key);
+    auto [it, found] = this->try_find(sort_key.get());
     if (!found)
     {
         PyErr_SetObject(PyExc_KeyError, key);
@@ -498,14 +1326,20 @@ PyObject* SortedDictType::getitem(PyObject* key)
  */
 int SortedDictType::setitem(PyObject* key, PyObject* value)
 {
-    if (!this->are_key_type_and_key_value_pair_good(key, value))
+    if (!this->is_modification_allowed())
+    {
+        return -1;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key, value));  // 🆕
+    if (sort_key == nullptr)
     {
         return -1;
     }
 
     // Insertion will be faster if the approximate location is known. Hence,
     // look for the nearest match.
-    auto [it, found] = this->try_find(key);
+    SortedDictKey sd_key(sort_key.get(), this->state);
+    auto [it, found] = this->try_find(sd_key);
 
     if (value == nullptr)
     {
@@ -519,9 +1353,10 @@ int SortedDictType::setitem(PyObject* key, PyObject* value)
         {
             return -1;
         }
-        Py_DECREF(it->first);
-        Py_DECREF(it->second.value);
+        it = this->prepare_modification(it);
+        SortedDictTreeEntry released = *it;
         this->map->erase(it);
+        release_item(released);
         return 0;
     }
 
@@ -529,11 +1364,17 @@ int SortedDictType::setitem(PyObject* key, PyObject* value)
     // the key (if applicable) and the value. If I ever plan to allow mutable
     // types as keys, I should store references to their copies instead. Like
     // the C++ standard library containers do.
+    it = this->prepare_modification(it);
     if (!found)
     {
         // Insert a new key-value pair. The hint is correct; the key will get
         // inserted just before it.
-        this->map->emplace_hint(it, Py_NewRef(key), value);  // 🆕
+        // The reference to the sort key is handed over to the tree.
+        this->map->emplace_hint(it, sd_key, key, value);
+        if (key != sort_key.release())
+        {
+            Py_INCREF(key);  // 🆕
+        }
     }
     else
     {
@@ -545,81 +1386,841 @@ int SortedDictType::setitem(PyObject* key, PyObject* value)
     return 0;
 }
 
-PyObject* SortedDictType::iter(PyTypeObject* type)
-{
-    return SortedDictKeysIterType<FwdIterType>::New(type, this);
-}
-
-PyObject* SortedDictType::reversed(PyTypeObject* type)
-{
-    return SortedDictKeysIterType<RevIterType>::New(type, this);
-}
-
-PyObject* SortedDictType::clear(void)
+/**
+ * Merge two sorted dictionaries into a new one. If a key is in both, the value
+ * it is mapped to in the second one wins.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ * @param state Module state.
+ *
+ * @return Sorted dictionary if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::or_(PyObject* a, PyObject* b, SortedDictModuleState* state)
 {
-    if (!this->is_deletion_allowed())
+    if (!PyObject_TypeCheck(a, state->sorted_dict_type) || !PyObject_TypeCheck(b, state->sorted_dict_type))
+    {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    PyCriticalSection2Locker _(a, b);
+    PyObjectWrapper sd_union(reinterpret_cast<SortedDictType*>(a)->copy());  // 🆕
+    if (sd_union == nullptr)
     {
         return nullptr;
     }
-    for (auto& item : *this->map)
+    if (!reinterpret_cast<SortedDictType*>(sd_union.get())->update_from_object(b))
     {
-        Py_DECREF(item.first);
-        Py_DECREF(item.second.value);
+        return nullptr;
     }
-    this->map->clear();
-    Py_RETURN_NONE;
+    return sd_union.release();
 }
 
-PyObject* SortedDictType::copy(void)
+/**
+ * Update this sorted dictionary with the keys and values from the given
+ * object.
+ *
+ * @param ob Object.
+ *
+ * @return This sorted dictionary if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::ior(PyObject* ob)
 {
-    PyTypeObject* type = Py_TYPE(this);
-    PyObject* sd_copy = type->tp_alloc(type, 0);  // 🆕
-    if (sd_copy == nullptr)
+    if (this->update_impl(&ob, 1) == nullptr)
     {
         return nullptr;
     }
-    SortedDictType* this_copy = reinterpret_cast<SortedDictType*>(sd_copy);
-    this_copy->map = new std::map<PyObject*, SortedDictValue, SortedDictKeyCompare>(*this->map);
-    for (auto& item : *this_copy->map)
-    {
-        Py_INCREF(item.first);  // 🆕
-        Py_INCREF(item.second.value);  // 🆕
-        item.second.known_referrers = 0;
-    }
-    this_copy->key_type = this->key_type;
-    this_copy->known_referrers = 0;
-    return sd_copy;
+    return Py_NewRef(this);  // 🆕
 }
 
-PyObject* SortedDictType::get(PyObject* const* args, Py_ssize_t nargs)
+/**
+ * Remove the key-value pairs at the positions in a slice. On failure, set a
+ * Python exception.
+ *
+ * @param start Start of the slice.
+ * @param stop Stop of the slice.
+ * @param step Step of the slice.
+ *
+ * @return 0 if successful, else -1.
+ */
+int SortedDictType::delete_slice(Py_ssize_t start, Py_ssize_t stop, Py_ssize_t step)
 {
-    if (!this->is_nargs_good(__func__, nargs, 1, 2))
+    if (!this->is_modification_allowed())
     {
-        return nullptr;
+        return -1;
     }
-    PyObject* key = args[0];
-    if (!this->are_key_type_and_key_value_pair_good(key))
+    Py_ssize_t slice_len = PySlice_AdjustIndices(this->map->size(), &start, &stop, step);
+    if (slice_len == 0)
     {
-        return nullptr;
+        return 0;
     }
-    auto [it, found] = this->try_find(key);
-    if (found)
+    if (step < 0)
     {
-        return Py_NewRef(it->second.value);  // 🆕
+        start += (slice_len - 1) * step;
+        step = -step;
+    }
+    FwdIterType first = this->map->nth(start);
+    if (step == 1)
+    {
+        return this->erase_range(first, this->map->advance(first, slice_len)) ? 0 : -1;
     }
-    PyObject* Default = nargs > 1 ? args[1] : Py_None;
-    return Py_NewRef(Default);  // 🆕
-}
-
-PyObject* SortedDictType::items(PyTypeObject* type)
-{
-    return SortedDictItemsType::New(type, this);
-}
-
-PyObject* SortedDictType::keys(PyTypeObject* type)
-{
-    return SortedDictKeysType::New(type, this);
-}
+
+    // The key-value pairs are not contiguous, so they have to be removed one
+    // at a time.
+    std::vector<FwdIterType> its{ first };
+    its.reserve(slice_len);
+    while (static_cast<Py_ssize_t>(its.size()) < slice_len)
+    {
+        its.push_back(this->map->advance(its.back(), step));
+    }
+    if (this->known_referrers != 0)
+    {
+        for (FwdIterType it : its)
+        {
+            if (!this->is_deletion_allowed(it->second.known_referrers))
+            {
+                return -1;
+            }
+        }
+    }
+    if (this->map->is_shared())
+    {
+        this->prepare_modification();
+        its.front() = this->map->nth(start);
+        for (std::size_t i = 1; i < its.size(); ++i)
+        {
+            its[i] = this->map->advance(its[i - 1], step);
+        }
+    }
+    std::vector<SortedDictTreeEntry> released;
+    released.reserve(slice_len);
+    for (FwdIterType it : its)
+    {
+        released.push_back(*it);
+        this->map->erase(it);
+    }
+    for (auto& item : released)
+    {
+        release_item(item);
+    }
+    return 0;
+}
+
+PyObject* SortedDictType::iter(PyTypeObject* type)
+{
+    return SortedDictKeysIterType<FwdIterType>::New(type, this);
+}
+
+PyObject* SortedDictType::reversed(PyTypeObject* type)
+{
+    return SortedDictKeysIterType<RevIterType>::New(type, this);
+}
+
+// Number of bytes a packed key occupies when pickling.
+constexpr Py_ssize_t PACKED_KEY_SIZE = 8;
+
+/**
+ * Check whether the keys of this sorted dictionary can be packed into a byte
+ * string when pickling. That is the case if they are all floating-point
+ * numbers or integers which fit in 64 bits.
+ *
+ * @return `true` if they can be packed, else `false`.
+ */
+bool SortedDictType::are_keys_packable(void)
+{
+    if (this->key_func != nullptr || (this->key_type != &PyFloat_Type && this->key_type != &PyLong_Type))
+    {
+        return false;
+    }
+    return std::all_of(
+        this->map->begin(), this->map->end(),
+        [](auto const& item)
+        {
+            return item.first.kind != SortedDictKey::Kind::OBJECT;
+        }
+    );
+}
+
+/**
+ * Pack the unboxed copy of a floating-point or integer key into 8 bytes in
+ * little-endian order, so that the result is portable across platforms.
+ *
+ * @param key Key.
+ * @param buf Destination.
+ */
+static void pack_key(SortedDictKey const& key, unsigned char* buf)
+{
+    std::uint64_t bits = key.kind == SortedDictKey::Kind::DOUBLE ? std::bit_cast<std::uint64_t>(key.native.d)
+                                                                 : static_cast<std::uint64_t>(key.native.ll);
+    for (Py_ssize_t i = 0; i < PACKED_KEY_SIZE; ++i)
+    {
+        buf[i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+}
+
+/**
+ * Unpack a floating-point or integer key packed by the above function.
+ *
+ * @param key_type Key type. Must be `float` or `int`.
+ * @param buf Source.
+ *
+ * @return Key if successful, else `nullptr`.
+ */
+static PyObject* unpack_key(PyTypeObject* key_type, unsigned char const* buf)
+{
+    std::uint64_t bits = 0;
+    for (Py_ssize_t i = 0; i < PACKED_KEY_SIZE; ++i)
+    {
+        bits |= static_cast<std::uint64_t>(buf[i]) << (8 * i);
+    }
+    if (key_type == &PyFloat_Type)
+    {
+        return PyFloat_FromDouble(std::bit_cast<double>(bits));  // 🆕
+    }
+    return PyLong_FromLongLong(static_cast<long long>(bits));  // 🆕
+}
+
+/**
+ * Obtain the information required to pickle this sorted dictionary: its type,
+ * no constructor arguments and its state. The state comprises the key type,
+ * the keys in ascending order (packed into a byte string if possible), the
+ * values in the same order and, if there is one, the key function.
+ *
+ * @return Tuple if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::reduce(void)
+{
+    Py_ssize_t sz = this->map->size();
+    PyObjectWrapper keys;
+    if (this->are_keys_packable())
+    {
+        keys.reset(PyBytes_FromStringAndSize(nullptr, sz * PACKED_KEY_SIZE));  // 🆕
+        if (keys == nullptr)
+        {
+            return nullptr;
+        }
+        unsigned char* buf = reinterpret_cast<unsigned char*>(PyBytes_AS_STRING(keys.get()));
+        for (auto& item : *this->map)
+        {
+            pack_key(item.first, buf);
+            buf += PACKED_KEY_SIZE;
+        }
+    }
+    else
+    {
+        keys.reset(PyList_New(sz));  // 🆕
+        if (keys == nullptr)
+        {
+            return nullptr;
+        }
+        Py_ssize_t idx = 0;
+        for (auto& item : *this->map)
+        {
+            PyList_SET_ITEM(keys.get(), idx++, Py_NewRef(item.key));  // 🆕
+        }
+    }
+    PyObjectWrapper values(PyList_New(sz));  // 🆕
+    if (values == nullptr)
+    {
+        return nullptr;
+    }
+    Py_ssize_t idx = 0;
+    for (auto& item : *this->map)
+    {
+        PyList_SET_ITEM(values.get(), idx++, Py_NewRef(item.second.value));  // 🆕
+    }
+    PyObject* key_type = this->key_type == nullptr ? Py_None : reinterpret_cast<PyObject*>(this->key_type);
+    if (this->key_func != nullptr)
+    {
+        return Py_BuildValue("O()(OOOO)", Py_TYPE(this), key_type, keys.get(), values.get(), this->key_func);  // 🆕
+    }
+    return Py_BuildValue("O()(OOO)", Py_TYPE(this), key_type, keys.get(), values.get());  // 🆕
+}
+
+/**
+ * Restore the state obtained when pickling a sorted dictionary. The state need
+ * not have been obtained from a sorted dictionary, so its keys are sorted and
+ * deduplicated like any others. If they are in ascending order (of their sort
+ * keys, if the state includes a key function) and this sorted dictionary is
+ * empty (as it is when unpickling), that takes one comparison per key, and the
+ * tree is built bottom-up.
+ *
+ * @param state State.
+ *
+ * @return `None` if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::setstate(PyObject* state)
+{
+    if (!this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+    if (!PyTuple_Check(state) || PyTuple_GET_SIZE(state) < 3 || PyTuple_GET_SIZE(state) > 4)
+    {
+        PyErr_Format(PyExc_TypeError, "got state %R, want tuple of length 3 or 4", state);
+        return nullptr;
+    }
+    PyObject* key_type = PyTuple_GET_ITEM(state, 0);
+    PyObject* keys = PyTuple_GET_ITEM(state, 1);
+    bool keys_packed = PyBytes_Check(keys);
+    PyObject* key_func = PyTuple_GET_SIZE(state) == 4 ? PyTuple_GET_ITEM(state, 3) : Py_None;
+    if (!is_key_func_good(key_func))
+    {
+        return nullptr;
+    }
+
+    // Copy the keys and values, so that they cannot change while being read.
+    PyObjectWrapper keys_tuple(keys_packed ? Py_NewRef(keys) : PySequence_Tuple(keys));  // 🆕
+    PyObjectWrapper values_tuple(PySequence_Tuple(PyTuple_GET_ITEM(state, 2)));  // 🆕
+    if (keys_tuple == nullptr || values_tuple == nullptr)
+    {
+        return nullptr;
+    }
+    if (keys_packed && PyBytes_GET_SIZE(keys) % PACKED_KEY_SIZE != 0)
+    {
+        PyErr_Format(
+            PyExc_ValueError, "got packed keys of size %zd, want size divisible by %zd", PyBytes_GET_SIZE(keys),
+            PACKED_KEY_SIZE
+        );
+        return nullptr;
+    }
+    Py_ssize_t keys_sz = keys_packed ? PyBytes_GET_SIZE(keys) / PACKED_KEY_SIZE : PyTuple_GET_SIZE(keys_tuple.get());
+    Py_ssize_t values_sz = PyTuple_GET_SIZE(values_tuple.get());
+    if (keys_sz != values_sz)
+    {
+        PyErr_Format(PyExc_ValueError, "got %zd keys and %zd values, want as many keys as values", keys_sz, values_sz);
+        return nullptr;
+    }
+
+    PyObject* new_key_type = Py_IsNone(key_type) ? reinterpret_cast<PyObject*>(this->key_type) : key_type;
+    if (keys_packed && keys_sz != 0 && new_key_type != reinterpret_cast<PyObject*>(&PyFloat_Type)
+        && new_key_type != reinterpret_cast<PyObject*>(&PyLong_Type))
+    {
+        PyErr_Format(PyExc_TypeError, "got packed keys, want key type %R or %R", &PyFloat_Type, &PyLong_Type);
+        return nullptr;
+    }
+    if (!Py_IsNone(key_type) && this->set_key_type(key_type) < 0)
+    {
+        return nullptr;
+    }
+    if (PyTuple_GET_SIZE(state) == 4 && !this->set_key_func(key_func))
+    {
+        return nullptr;
+    }
+
+    unsigned char const* buf = keys_packed ? reinterpret_cast<unsigned char const*>(PyBytes_AS_STRING(keys)) : nullptr;
+    std::vector<SortedDictTreeEntry> items;
+    items.reserve(keys_sz);
+    for (Py_ssize_t i = 0; i < keys_sz; ++i)
+    {
+        PyObjectWrapper key(
+            keys_packed ? unpack_key(this->key_type, buf + i * PACKED_KEY_SIZE)
+                        : Py_NewRef(PyTuple_GET_ITEM(keys_tuple.get(), i))
+        );  // 🆕
+        if (key == nullptr || !this->buffer_item(items, key.get(), PyTuple_GET_ITEM(values_tuple.get(), i)))
+        {
+            for (auto& item : items)
+            {
+                release_item(item);
+            }
+            return nullptr;
+        }
+    }
+
+    this->insert_items(items);
+    Py_RETURN_NONE;
+}
+
+/**
+ * Copy the unboxed copies of the keys into a contiguous array in one pass over
+ * the tree. Only floating-point keys and integer keys which fit in 64 bits have
+ * unboxed copies.
+ *
+ * @return Memory view over the array if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::keys_to_buffer(void)
+{
+    if (this->key_func != nullptr)
+    {
+        PyErr_SetString(PyExc_TypeError, "operation not permitted: sorted dictionary has a key function");
+        return nullptr;
+    }
+    if (this->key_type == nullptr)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "key type not set: insert at least one item first");
+        return nullptr;
+    }
+    if (this->key_type != &PyFloat_Type && this->key_type != &PyLong_Type)
+    {
+        PyErr_Format(
+            PyExc_TypeError, "got key type %R, want key type %R or %R", this->key_type, &PyFloat_Type, &PyLong_Type
+        );
+        return nullptr;
+    }
+    static_assert(sizeof(double) == PACKED_KEY_SIZE && sizeof(long long) == PACKED_KEY_SIZE);
+    PyObjectWrapper bytes(PyBytes_FromStringAndSize(nullptr, this->map->size() * PACKED_KEY_SIZE));  // 🆕
+    if (bytes == nullptr)
+    {
+        return nullptr;
+    }
+    char* buf = PyBytes_AS_STRING(bytes.get());
+    for (auto const& item : *this->map)
+    {
+        if (item.first.kind == SortedDictKey::Kind::OBJECT)
+        {
+            PyErr_Format(PyExc_OverflowError, "got key %R, want key which fits in 64 bits", item.first.ob);
+            return nullptr;
+        }
+        if (item.first.kind == SortedDictKey::Kind::DOUBLE)
+        {
+            std::memcpy(buf, &item.first.native.d, PACKED_KEY_SIZE);
+        }
+        else
+        {
+            std::memcpy(buf, &item.first.native.ll, PACKED_KEY_SIZE);
+        }
+        buf += PACKED_KEY_SIZE;
+    }
+    PyObjectWrapper memoryview(PyMemoryView_FromObject(bytes.get()));  // 🆕
+    if (memoryview == nullptr)
+    {
+        return nullptr;
+    }
+    return PyObject_CallMethod(memoryview.get(), "cast", "s", this->key_type == &PyFloat_Type ? "d" : "q");  // 🆕
+}
+
+/**
+ * Find the number of keys less than the given key.
+ *
+ * @param key Key.
+ *
+ * @return Number of keys if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::bisect_left(PyObject* key)
+{
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    return PyLong_FromSize_t(this->map->rank(it));  // 🆕
+}
+
+/**
+ * Find the number of keys less than or equal to the given key.
+ *
+ * @param key Key.
+ *
+ * @return Number of keys if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::bisect_right(PyObject* key)
+{
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    return PyLong_FromSize_t(this->map->rank(it) + found);  // 🆕
+}
+
+PyObject* SortedDictType::ceiling_item(PyObject* key)
+{
+    return this->nearest(key, true, true, true);
+}
+
+PyObject* SortedDictType::ceiling_key(PyObject* key)
+{
+    return this->nearest(key, true, true, false);
+}
+
+PyObject* SortedDictType::clear(void)
+{
+    if (!this->is_deletion_allowed())
+    {
+        return nullptr;
+    }
+    if (!this->is_snapshot && this->map->is_shared())
+    {
+        // Leave the tree to the snapshots sharing it instead of copying it.
+        release_map(this->map);
+        this->map = new SortedDictTree;
+        Py_RETURN_NONE;
+    }
+    if (!this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+    for (auto& item : *this->map)
+    {
+        release_item(item);
+    }
+    this->map->clear();
+    Py_RETURN_NONE;
+}
+
+PyObject* SortedDictType::copy(void)
+{
+    PyTypeObject* type = Py_TYPE(this);
+    PyObject* sd_copy = type->tp_alloc(type, 0);  // 🆕
+    if (sd_copy == nullptr)
+    {
+        return nullptr;
+    }
+    SortedDictType* this_copy = reinterpret_cast<SortedDictType*>(sd_copy);
+    this_copy->map = new SortedDictTree(*this->map);
+    for (auto& item : *this_copy->map)
+    {
+        acquire_item(item);
+        item.second.known_referrers = 0;
+    }
+    this_copy->state = this->state;
+    this_copy->key_type = this->key_type;
+    this_copy->key_element_types = Py_XNewRef(this->key_element_types);
+    this_copy->key_func = Py_XNewRef(this->key_func);
+    this_copy->known_referrers = 0;
+    this_copy->is_snapshot = false;
+    this_copy->retired_map = nullptr;
+    return sd_copy;
+}
+
+/**
+ * Remove the key-value pairs whose keys lie in a range. On failure, set a
+ * Python exception.
+ *
+ * @param args Positional arguments.
+ * @param kwargs Keyword arguments.
+ *
+ * @return `None` if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::delete_range(PyObject* args, PyObject* kwargs)
+{
+    static char const* keywords[] = { "lo", "hi", "inclusive", nullptr };
+    PyObject* lo = Py_None;
+    PyObject* hi = Py_None;
+    int lo_inclusive = 1, hi_inclusive = 1;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OO(pp):delete_range", const_cast<char**>(keywords), &lo, &hi, &lo_inclusive,
+            &hi_inclusive
+        ))
+    {
+        return nullptr;
+    }
+    if (!this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+
+    // Keys can't be `None`, so it can stand for a missing bound.
+    PyObjectWrapper lo_sort_key(Py_IsNone(lo) ? nullptr : this->sort_key_of(lo));  // 🆕
+    if (!Py_IsNone(lo) && lo_sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    PyObjectWrapper hi_sort_key(Py_IsNone(hi) ? nullptr : this->sort_key_of(hi));  // 🆕
+    if (!Py_IsNone(hi) && hi_sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    lo = lo_sort_key.get();
+    hi = hi_sort_key.get();
+
+    FwdIterType first = this->map->begin();
+    if (lo != nullptr)
+    {
+        bool found;
+        std::tie(first, found) = this->try_find(lo);
+        if (found && !lo_inclusive)
+        {
+            ++first;
+        }
+    }
+    FwdIterType last = this->map->end();
+    if (hi != nullptr)
+    {
+        bool found;
+        std::tie(last, found) = this->try_find(hi);
+        if (found && hi_inclusive)
+        {
+            ++last;
+        }
+    }
+
+    // If the lower bound exceeds the upper bound, the range is empty.
+    if (this->map->rank(first) < this->map->rank(last) && !this->erase_range(first, last))
+    {
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* SortedDictType::floor_item(PyObject* key)
+{
+    return this->nearest(key, false, true, true);
+}
+
+PyObject* SortedDictType::floor_key(PyObject* key)
+{
+    return this->nearest(key, false, true, false);
+}
+
+PyObject* SortedDictType::get(PyObject* const* args, Py_ssize_t nargs)
+{
+    if (!this->is_nargs_good(__func__, nargs, 1, 2))
+    {
+        return nullptr;
+    }
+    PyObject* key = args[0];
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    if (found)
+    {
+        return Py_NewRef(it->second.value);  // 🆕
+    }
+    PyObject* Default = nargs > 1 ? args[1] : Py_None;
+    return Py_NewRef(Default);  // 🆕
+}
+
+PyObject* SortedDictType::higher_item(PyObject* key)
+{
+    return this->nearest(key, true, false, true);
+}
+
+PyObject* SortedDictType::higher_key(PyObject* key)
+{
+    return this->nearest(key, true, false, false);
+}
+
+/**
+ * Find the position of a key. On failure, set a Python exception.
+ *
+ * @param key Key.
+ *
+ * @return Position if present, else `nullptr`.
+ */
+PyObject* SortedDictType::index(PyObject* key)
+{
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    if (!found)
+    {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    return PyLong_FromSize_t(this->map->rank(it));  // 🆕
+}
+
+/**
+ * Create an iterator over the keys in a range. On failure, set a Python
+ * exception.
+ *
+ * @param args Positional arguments.
+ * @param kwargs Keyword arguments.
+ * @param fwd_type Forward iterator type.
+ * @param rev_type Reverse iterator type.
+ *
+ * @return Iterator if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::irange(PyObject* args, PyObject* kwargs, PyTypeObject* fwd_type, PyTypeObject* rev_type)
+{
+    static char const* keywords[] = { "lo", "hi", "inclusive", "reverse", nullptr };
+    PyObject* lo = Py_None;
+    PyObject* hi = Py_None;
+    int lo_inclusive = 1, hi_inclusive = 1, reverse = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OO(pp)p:irange", const_cast<char**>(keywords), &lo, &hi, &lo_inclusive, &hi_inclusive,
+            &reverse
+        ))
+    {
+        return nullptr;
+    }
+
+    // Keys can't be `None`, so it can stand for a missing bound.
+    PyObjectWrapper lo_sort_key(Py_IsNone(lo) ? nullptr : this->sort_key_of(lo));  // 🆕
+    if (!Py_IsNone(lo) && lo_sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    PyObjectWrapper hi_sort_key(Py_IsNone(hi) ? nullptr : this->sort_key_of(hi));  // 🆕
+    if (!Py_IsNone(hi) && hi_sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    lo = lo_sort_key.get();
+    hi = hi_sort_key.get();
+
+    // Seek to the first key in the range. The iterator compares every key it
+    // yields with the other bound, so the last key need not be found.
+    if (!reverse)
+    {
+        FwdIterType it = this->map->begin();
+        if (lo != nullptr)
+        {
+            bool found;
+            std::tie(it, found) = this->try_find(lo);
+            if (found && !lo_inclusive)
+            {
+                ++it;
+            }
+        }
+        return SortedDictKeysIterType<FwdIterType>::New(fwd_type, this, it, hi, hi_inclusive);
+    }
+    FwdIterType it = this->map->end();
+    if (hi != nullptr)
+    {
+        bool found;
+        std::tie(it, found) = this->try_find(hi);
+        if (found && hi_inclusive)
+        {
+            ++it;
+        }
+    }
+    return SortedDictKeysIterType<RevIterType>::New(rev_type, this, RevIterType(it), lo, lo_inclusive);
+}
+
+PyObject* SortedDictType::items(PyTypeObject* type)
+{
+    return SortedDictItemsType::New(type, this);
+}
+
+PyObject* SortedDictType::keys(PyTypeObject* type)
+{
+    return SortedDictKeysType::New(type, this);
+}
+
+PyObject* SortedDictType::lower_item(PyObject* key)
+{
+    return this->nearest(key, false, false, true);
+}
+
+PyObject* SortedDictType::lower_key(PyObject* key)
+{
+    return this->nearest(key, false, false, false);
+}
+
+PyObject* SortedDictType::peekitem(PyObject* const* args, Py_ssize_t nargs)
+{
+    Py_ssize_t position;
+    if (!this->is_nargs_good(__func__, nargs, 0, 1) || !this->parse_position(args, nargs, position))
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_nth(position);
+    if (!found)
+    {
+        return nullptr;
+    }
+    return PyTuple_Pack(2, it->key, it->second.value);  // 🆕
+}
+
+/**
+ * Remove a key and return the value mapped to it. On failure, set a Python
+ * exception.
+ *
+ * @param args Arguments: the key and, optionally, the default value.
+ * @param nargs Number of arguments.
+ *
+ * @return Value if the key was present, default value if it was not and a
+ * default value was provided, else `nullptr`.
+ */
+PyObject* SortedDictType::pop(PyObject* const* args, Py_ssize_t nargs)
+{
+    if (!this->is_nargs_good(__func__, nargs, 1, 2))
+    {
+        return nullptr;
+    }
+    PyObject* key = args[0];
+    if (!this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
+    {
+        return nullptr;
+    }
+    auto [it, found] = this->try_find(sort_key.get());
+    if (!found)
+    {
+        if (nargs > 1)
+        {
+            return Py_NewRef(args[1]);  // 🆕
+        }
+        PyErr_SetObject(PyExc_KeyError, key);
+        return nullptr;
+    }
+    if (!this->is_deletion_allowed(it->second.known_referrers))
+    {
+        return nullptr;
+    }
+    it = this->prepare_modification(it);
+
+    // The reference to the value held by this sorted dictionary is handed over
+    // to the caller.
+    SortedDictTreeEntry released = *it;
+    this->map->erase(it);
+    if (released.key != released.first.ob)
+    {
+        Py_DECREF(released.key);
+    }
+    Py_DECREF(released.first.ob);
+    return released.second.value;
+}
+
+/**
+ * Remove the key-value pair at a position and return it. On failure, set a
+ * Python exception.
+ *
+ * @param args Arguments: optionally, the position.
+ * @param nargs Number of arguments.
+ *
+ * @return Key-value pair if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::popitem(PyObject* const* args, Py_ssize_t nargs)
+{
+    Py_ssize_t position;
+    if (!this->is_nargs_good(__func__, nargs, 0, 1) || !this->parse_position(args, nargs, position)
+        || !this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+    if (this->map->size() == 0)
+    {
+        PyErr_SetString(PyExc_KeyError, "popitem(): sorted dictionary is empty");
+        return nullptr;
+    }
+    auto [it, found] = this->try_nth(position);
+    if (!found || !this->is_deletion_allowed(it->second.known_referrers))
+    {
+        return nullptr;
+    }
+    PyObject* item = PyTuple_New(2);  // 🆕
+    if (item == nullptr)
+    {
+        return nullptr;
+    }
+
+    // The references to the key and value held by this sorted dictionary are
+    // handed over to the tuple.
+    it = this->prepare_modification(it);
+    SortedDictTreeEntry released = *it;
+    this->map->erase(it);
+    PyTuple_SET_ITEM(item, 0, released.key);
+    PyTuple_SET_ITEM(item, 1, released.second.value);
+    if (released.key != released.first.ob)
+    {
+        Py_DECREF(released.first.ob);
+    }
+    return item;
+}
 
 PyObject* SortedDictType::setdefault(PyObject* const* args, Py_ssize_t nargs)
 {
@@ -628,20 +2229,66 @@ PyObject* SortedDictType::setdefault(PyObject* const* args, Py_ssize_t nargs)
         return nullptr;
     }
     PyObject* key = args[0];
-    if (!this->are_key_type_and_key_value_pair_good(key))
+    if (!this->is_modification_allowed())
+    {
+        return nullptr;
+    }
+    PyObjectWrapper sort_key(this->sort_key_of(key));  // 🆕
+    if (sort_key == nullptr)
     {
         return nullptr;
     }
-    auto [it, found] = this->try_find(key);
+    SortedDictKey sd_key(sort_key.get(), this->state);
+    auto [it, found] = this->try_find(sd_key);
     if (found)
     {
         return Py_NewRef(it->second.value);  // 🆕
     }
     PyObject* Default = nargs > 1 ? args[1] : Py_None;
-    this->map->emplace_hint(it, Py_NewRef(key), Py_NewRef(Default));  // 🆕
+
+    // The reference to the sort key is handed over to the tree.
+    it = this->prepare_modification(it);
+    this->map->emplace_hint(it, sd_key, key, Py_NewRef(Default));  // 🆕
+    if (key != sort_key.release())
+    {
+        Py_INCREF(key);  // 🆕
+    }
     return Py_NewRef(Default);  // 🆕
 }
 
+/**
+ * Take a snapshot of this sorted dictionary. The snapshot shares the tree of
+ * this sorted dictionary, which is copied only when the latter is next
+ * modified.
+ *
+ * @return Snapshot if successful, else `nullptr`.
+ */
+PyObject* SortedDictType::snapshot(void)
+{
+    if (this->is_snapshot)
+    {
+        // It cannot change, so it is its own snapshot.
+        return Py_NewRef(this);  // 🆕
+    }
+    PyTypeObject* type = Py_TYPE(this);
+    PyObject* sd_snapshot = type->tp_alloc(type, 0);  // 🆕
+    if (sd_snapshot == nullptr)
+    {
+        return nullptr;
+    }
+    SortedDictType* this_snapshot = reinterpret_cast<SortedDictType*>(sd_snapshot);
+    this->map->acquire();
+    this_snapshot->map = this->map;
+    this_snapshot->state = this->state;
+    this_snapshot->key_type = this->key_type;
+    this_snapshot->key_element_types = Py_XNewRef(this->key_element_types);
+    this_snapshot->key_func = Py_XNewRef(this->key_func);
+    this_snapshot->known_referrers = 0;
+    this_snapshot->is_snapshot = true;
+    this_snapshot->retired_map = nullptr;
+    return sd_snapshot;
+}
+
 PyObject* SortedDictType::update(PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames)
 {
     if (!this->is_nargs_good(__func__, nargs, 0, 1))
@@ -656,6 +2303,15 @@ PyObject* SortedDictType::values(PyTypeObject* type)
     return SortedDictValuesType::New(type, this);
 }
 
+PyObject* SortedDictType::get_key(void)
+{
+    if (this->key_func == nullptr)
+    {
+        Py_RETURN_NONE;
+    }
+    return Py_NewRef(this->key_func);  // 🆕
+}
+
 PyObject* SortedDictType::get_key_type(void)
 {
     if (this->key_type == nullptr)
@@ -683,6 +2339,10 @@ int SortedDictType::set_key_type(PyObject* key_type)
         return -1;
     }
 
+    if (!this->is_modification_allowed())
+    {
+        return -1;
+    }
     if (!this->try_set_key_type(key_type))
     {
         PyErr_Format(PyExc_ValueError, "got %R, want a supported key type", key_type);
@@ -697,7 +2357,7 @@ int SortedDictType::init(PyObject* args, PyObject* kwargs)
     // I call internally uses the fast calling convention for performance, it
     // is necessary to convert the tuple of positional arguments into a C array
     // of argument values. Said method ignores keyword arguments, so I ignore
-    // them here, too.
+    // them here, too, except for the key function.
     PyObjectWrapper args_seq(PySequence_Fast(args, nullptr));  // 🆕
     PyObject** update_args = PySequence_Fast_ITEMS(args_seq.get());
     Py_ssize_t update_nargs = PySequence_Fast_GET_SIZE(args_seq.get());
@@ -705,6 +2365,11 @@ int SortedDictType::init(PyObject* args, PyObject* kwargs)
     {
         return -1;
     }
+    PyObject* key_func = kwargs == nullptr ? nullptr : PyDict_GetItemString(kwargs, "key");
+    if (key_func != nullptr && !this->set_key_func(key_func))
+    {
+        return -1;
+    }
     return this->update_impl(update_args, update_nargs) == nullptr ? -1 : 0;
 }
 
@@ -720,8 +2385,13 @@ PyObject* SortedDictType::New(PyTypeObject* type, PyObject* args, PyObject* kwar
     // allocated memory to null, but actually writes zeros to it. Hence,
     // explicitly initialise them.
     SortedDictType* sd = reinterpret_cast<SortedDictType*>(self);
-    sd->map = new std::map<PyObject*, SortedDictValue, SortedDictKeyCompare>;
+    sd->map = new SortedDictTree;
+    sd->state = sorted_dict_module_state_of(type);
     sd->key_type = nullptr;
+    sd->key_element_types = nullptr;
+    sd->key_func = nullptr;
     sd->known_referrers = 0;
+    sd->is_snapshot = false;
+    sd->retired_map = nullptr;
     return self;
 }
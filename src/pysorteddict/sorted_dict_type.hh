@@ -4,45 +4,14 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <iterator>
-#include <map>
 #include <utility>
+#include <vector>
 
-/**
- * C++-style comparison implementation for Python objects.
- */
-struct SortedDictKeyCompare
-{
-    bool operator()(PyObject* a, PyObject* b) const
-    {
-        // There must exist a total order on the set of possible keys. (Else,
-        // this comparison may error out.) Hence, only instances of the type
-        // of the first key inserted may be used as keys. (Instances of types
-        // derived from that type are not allowed, because comparisons between
-        // them can be customised to error out. Check the code to see how this
-        // is enforced.) With these precautions, this comparison should always
-        // work.
-        return PyObject_RichCompareBool(a, b, Py_LT) == 1;
-    }
-};
-
-struct SortedDictValue
-{
-public:
-    PyObject* value;
+#include "sorted_dict_module.hh"
+#include "sorted_dict_tree.hh"
 
-    // Number of objects which require access to the key-value pair this value
-    // is part of. They will all hold references to the containing sorted
-    // dictionary.
-    Py_ssize_t known_referrers;
-
-public:
-    SortedDictValue(PyObject* value) : value(value), known_referrers(0)
-    {
-    }
-};
-
-using FwdIterType = std::map<PyObject*, SortedDictValue, SortedDictKeyCompare>::iterator;
-using RevIterType = std::reverse_iterator<FwdIterType>;
+using FwdIterType = SortedDictTree::iterator;
+using RevIterType = SortedDictTree::reverse_iterator;
 
 struct SortedDictType
 {
@@ -53,25 +22,67 @@ private:
     // Pointer to an object on the heap. Can't be the object itself, because
     // this container will be allocated a definite amount of space, which won't
     // allow the object to grow.
-    std::map<PyObject*, SortedDictValue, SortedDictKeyCompare>* map;
+    SortedDictTree* map;
 
-    // The type of each key.
+    // State of the module which created the type of this object.
+    SortedDictModuleState* state;
+
+    // The type of each key. If there is a key function, this is the type of
+    // the sort keys it returns instead.
     PyTypeObject* key_type;
 
+    // If the key type is `tuple`, the type of each element of a key, fixed
+    // when the first key is inserted. Else, null.
+    PyObject* key_element_types;
+
+    // Function called on each key to obtain the sort key it is ordered by, or
+    // null if each key is its own sort key.
+    PyObject* key_func;
+
     // Number of objects which require access to any key-value pair in this
     // sorted dictionary. They will all hold references to the latter.
     Py_ssize_t known_referrers;
 
+    // Whether this is a snapshot of another sorted dictionary. A snapshot
+    // shares its tree with the sorted dictionary it was taken from until the
+    // latter is modified, so it cannot itself be modified.
+    bool is_snapshot;
+
+    // Oldest tree this sorted dictionary used before its current one, if any.
+    // Trees are kept alive while iterators may reference them.
+    SortedDictTree* retired_map;
+
 private:
     bool try_set_key_type(PyObject*);
+    bool try_set_key_element_types(PyObject*);
+    static bool are_key_elements_good(PyObject*, PyObject*);
+    PyObject* sort_key_of(PyObject*, PyObject* value = nullptr);
+    bool set_key_func(PyObject*);
     bool is_key_good(PyObject*);
+    static bool is_key_good(PyObject*, PyTypeObject*, SortedDictModuleState*);
     bool are_key_type_and_key_value_pair_good(PyObject*, PyObject* value = nullptr);
     bool is_deletion_allowed(void);
     static bool is_deletion_allowed(Py_ssize_t);
+    bool is_modification_allowed(void);
+    void unshare_map(void);
+    void prepare_modification(void);
+    FwdIterType prepare_modification(FwdIterType);
+    void release_retired_maps(void);
+    static void release_map(SortedDictTree*);
     static bool is_nargs_good(char const*, Py_ssize_t, int, int);
+    std::pair<FwdIterType, bool> try_find(SortedDictKey const&);
     std::pair<FwdIterType, bool> try_find(PyObject*);
-    bool update_from_mapping(PyObject*);
-    bool update_from_sequence(PyObject*);
+    static bool parse_position(PyObject* const*, Py_ssize_t, Py_ssize_t&);
+    std::pair<FwdIterType, bool> try_nth(Py_ssize_t);
+    PyObject* nearest(PyObject*, bool, bool, bool);
+    bool erase_range(FwdIterType, FwdIterType);
+    bool are_keys_packable(void);
+    bool buffer_item(std::vector<SortedDictTreeEntry>&, PyObject*, PyObject*);
+    void insert_items(std::vector<SortedDictTreeEntry>&);
+    bool update_from_mapping(PyObject*, std::vector<SortedDictTreeEntry>&);
+    bool update_from_sequence(PyObject*, std::vector<SortedDictTreeEntry>&);
+    bool update_from_sorted_dict(SortedDictType*, std::vector<SortedDictTreeEntry>&);
+    bool update_from_sorted_dict_keys(SortedDictType*, std::vector<SortedDictTreeEntry>&);
     bool update_from_object(PyObject*);
     PyObject* update_impl(PyObject* const*, Py_ssize_t);
 
@@ -82,21 +93,46 @@ public:
     Py_ssize_t len(void);
     PyObject* getitem(PyObject*);
     int setitem(PyObject*, PyObject*);
+    static PyObject* or_(PyObject*, PyObject*, SortedDictModuleState*);
+    PyObject* ior(PyObject*);
     PyObject* iter(PyTypeObject*);
     PyObject* reversed(PyTypeObject*);
+    int delete_slice(Py_ssize_t, Py_ssize_t, Py_ssize_t);
+    PyObject* keys_to_buffer(void);
+    PyObject* reduce(void);
+    PyObject* setstate(PyObject*);
+    PyObject* bisect_left(PyObject*);
+    PyObject* bisect_right(PyObject*);
+    PyObject* ceiling_item(PyObject*);
+    PyObject* ceiling_key(PyObject*);
     PyObject* clear(void);
     PyObject* copy(void);
+    PyObject* delete_range(PyObject*, PyObject*);
+    PyObject* floor_item(PyObject*);
+    PyObject* floor_key(PyObject*);
     PyObject* get(PyObject* const*, Py_ssize_t);
+    PyObject* higher_item(PyObject*);
+    PyObject* higher_key(PyObject*);
+    PyObject* index(PyObject*);
+    PyObject* irange(PyObject*, PyObject*, PyTypeObject*, PyTypeObject*);
     PyObject* items(PyTypeObject*);
     PyObject* keys(PyTypeObject*);
+    PyObject* lower_item(PyObject*);
+    PyObject* lower_key(PyObject*);
+    PyObject* peekitem(PyObject* const*, Py_ssize_t);
+    PyObject* pop(PyObject* const*, Py_ssize_t);
+    PyObject* popitem(PyObject* const*, Py_ssize_t);
     PyObject* setdefault(PyObject* const*, Py_ssize_t);
+    PyObject* snapshot(void);
     PyObject* update(PyObject* const*, Py_ssize_t, PyObject*);
     PyObject* values(PyTypeObject*);
+    PyObject* get_key(void);
     PyObject* get_key_type(void);
     int set_key_type(PyObject*);
     int init(PyObject*, PyObject*);
     static PyObject* New(PyTypeObject*, PyObject*, PyObject*);
 
+    friend struct FrozenSortedDictType;
     template<typename T>
     friend struct SortedDictViewIterType;
     friend struct SortedDictViewType;
@@ -34,4 +34,89 @@ struct PyErrorClearer
     }
 };
 
+/**
+ * Automatic pre-return restorer of the Python error indicator. Clears it until
+ * then, so that Python code can be run even if an exception is pending.
+ */
+struct PyErrorStasher
+{
+#if PY_VERSION_HEX >= 0x030C0000
+    PyObject* exc;
+
+    PyErrorStasher(void) : exc(PyErr_GetRaisedException())
+    {
+    }
+
+    ~PyErrorStasher(void)
+    {
+        PyErr_SetRaisedException(this->exc);
+    }
+#else
+    PyObject *type, *value, *traceback;
+
+    PyErrorStasher(void)
+    {
+        PyErr_Fetch(&this->type, &this->value, &this->traceback);
+    }
+
+    ~PyErrorStasher(void)
+    {
+        PyErr_Restore(this->type, this->value, this->traceback);
+    }
+#endif
+};
+
+/**
+ * Automatic pre-return ender of a critical section on a Python object. On a
+ * free-threaded build, no other thread can enter a critical section on the
+ * object until then. (As with the GIL, the critical section may be suspended
+ * if this thread blocks.) On other builds, the GIL is enough, and this does
+ * nothing.
+ */
+struct PyCriticalSectionLocker
+{
+#ifdef Py_GIL_DISABLED
+    PyCriticalSection cs;
+
+    PyCriticalSectionLocker(PyObject* ob)
+    {
+        PyCriticalSection_Begin(&this->cs, ob);
+    }
+
+    ~PyCriticalSectionLocker(void)
+    {
+        PyCriticalSection_End(&this->cs);
+    }
+#else
+    PyCriticalSectionLocker(PyObject*)
+    {
+    }
+#endif
+};
+
+/**
+ * Same as the above, but for two Python objects. Locks them in a consistent
+ * order, so that two threads locking the same objects cannot deadlock.
+ */
+struct PyCriticalSection2Locker
+{
+#ifdef Py_GIL_DISABLED
+    PyCriticalSection2 cs;
+
+    PyCriticalSection2Locker(PyObject* a, PyObject* b)
+    {
+        PyCriticalSection2_Begin(&this->cs, a, b);
+    }
+
+    ~PyCriticalSection2Locker(void)
+    {
+        PyCriticalSection2_End(&this->cs);
+    }
+#else
+    PyCriticalSection2Locker(PyObject*, PyObject*)
+    {
+    }
+#endif
+};
+
 #endif
@@ -1,6 +1,5 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
-#include <map>
 
 #include "sorted_dict_type.hh"
 #include "sorted_dict_values_type.hh"
@@ -1,12 +1,77 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <algorithm>
-#include <map>
 
 #include "sorted_dict_type.hh"
 #include "sorted_dict_utils.hh"
 #include "sorted_dict_view_type.hh"
 
+/**
+ * Check whether the key-value pair the given forward iterator references lies
+ * beyond the key at which iteration stops.
+ *
+ * @param it Iterator. Must not be the end iterator.
+ *
+ * @return `true` if iteration should stop, else `false`.
+ */
+template<>
+bool SortedDictViewIterType<FwdIterType>::is_beyond_stop(FwdIterType it)
+{
+    if (this->stop.ob == nullptr)
+    {
+        return false;
+    }
+    auto comp = this->sd->map->key_comp();
+    return this->stop_inclusive ? comp(this->stop, it->first) : !comp(it->first, this->stop);
+}
+
+/**
+ * Check whether the key-value pair the given reverse iterator references lies
+ * beyond the key at which iteration stops.
+ *
+ * @param it Iterator. Must not be the end iterator.
+ *
+ * @return `true` if iteration should stop, else `false`.
+ */
+template<>
+bool SortedDictViewIterType<RevIterType>::is_beyond_stop(RevIterType it)
+{
+    if (this->stop.ob == nullptr)
+    {
+        return false;
+    }
+    auto comp = this->sd->map->key_comp();
+    return this->stop_inclusive ? comp(it->first, this->stop) : !comp(this->stop, it->first);
+}
+
+/**
+ * Check whether the given forward iterator references a key-value pair which
+ * should be yielded.
+ *
+ * @param it Iterator.
+ *
+ * @return `true` if iteration should continue, else `false`.
+ */
+template<>
+bool SortedDictViewIterType<FwdIterType>::has_next(FwdIterType it)
+{
+    return it != this->sd->map->end() && !this->is_beyond_stop(it);
+}
+
+/**
+ * Check whether the given reverse iterator references a key-value pair which
+ * should be yielded.
+ *
+ * @param it Iterator.
+ *
+ * @return `true` if iteration should continue, else `false`.
+ */
+template<>
+bool SortedDictViewIterType<RevIterType>::has_next(RevIterType it)
+{
+    return it != this->sd->map->rend() && !this->is_beyond_stop(it);
+}
+
 /**
  * Do all the necessary bookkeeping required to start tracking the given
  * forward iterator of the underlying sorted dictionary.
@@ -19,15 +84,15 @@
 template<>
 void SortedDictViewIterType<FwdIterType>::track(FwdIterType it)
 {
-    if (it == this->sd->map->begin())
-    {
-        this->track_begin();
-    }
-    if (it != this->sd->map->end())
+    if (this->has_next(it))
     {
         // Indicate that the key-value pair this iterator references must not
-        // be erased: erasure would invalidate the iterator.
-        ++it->second.known_referrers;
+        // be erased: erasure would invalidate the iterator. (Nothing can be
+        // erased from a snapshot.)
+        if (!this->sd->is_snapshot)
+        {
+            ++it->second.known_referrers;
+        }
     }
     else
     {
@@ -47,17 +112,13 @@ void SortedDictViewIterType<FwdIterType>::track(FwdIterType it)
 template<>
 void SortedDictViewIterType<RevIterType>::track(RevIterType it)
 {
-    if (it == this->sd->map->rbegin())
-    {
-        this->track_begin();
-    }
-    if (it != this->sd->map->rend())
+    if (this->has_next(it))
     {
         // A reverse iterator is anchored by its underlying forward iterator.
         // If this forward iterator references a key-value pair, indicate that
         // it must not be erased: erasure would invalidate both iterators.
         FwdIterType it_base = it.base();
-        if (it_base != this->sd->map->end())
+        if (it_base != this->sd->map->end() && !this->sd->is_snapshot)
         {
             ++it_base->second.known_referrers;
         }
@@ -71,7 +132,6 @@ void SortedDictViewIterType<RevIterType>::track(RevIterType it)
 template<typename T>
 void SortedDictViewIterType<T>::track_begin(void)
 {
-    Py_INCREF(this->sd);  // 🆕
     ++this->sd->known_referrers;
     this->should_raise_stop_iteration = false;
 }
@@ -80,8 +140,33 @@ template<typename T>
 void SortedDictViewIterType<T>::track_end(void)
 {
     this->should_raise_stop_iteration = true;
-    --this->sd->known_referrers;
-    Py_DECREF(this->sd);
+    if (--this->sd->known_referrers == 0)
+    {
+        // No iterators reference the trees the sorted dictionary used before
+        // its current one.
+        this->sd->release_retired_maps();
+    }
+}
+
+/**
+ * Move the forward iterator member to the current tree of the underlying
+ * sorted dictionary, in case the latter replaced its tree (because it was
+ * shared with a snapshot) since the iterator was last used.
+ */
+template<>
+void SortedDictViewIterType<FwdIterType>::follow(void)
+{
+    this->it = this->sd->map->follow(this->it);
+}
+
+/**
+ * Move the reverse iterator member to the current tree of the underlying
+ * sorted dictionary. See above.
+ */
+template<>
+void SortedDictViewIterType<RevIterType>::follow(void)
+{
+    this->it = RevIterType(this->sd->map->follow(this->it.base()));
 }
 
 /**
@@ -96,7 +181,10 @@ void SortedDictViewIterType<T>::track_end(void)
 template<>
 void SortedDictViewIterType<FwdIterType>::untrack(FwdIterType it)
 {
-    --it->second.known_referrers;
+    if (!this->sd->is_snapshot)
+    {
+        --it->second.known_referrers;
+    }
 }
 
 /**
@@ -112,7 +200,7 @@ template<>
 void SortedDictViewIterType<RevIterType>::untrack(RevIterType it)
 {
     FwdIterType it_base = it.base();
-    if (it_base != this->sd->map->end())
+    if (it_base != this->sd->map->end() && !this->sd->is_snapshot)
     {
         --it_base->second.known_referrers;
     }
@@ -124,20 +212,28 @@ void SortedDictViewIterType<T>::Delete(PyObject* self)
     SortedDictViewIterType<T>* sdvi = reinterpret_cast<SortedDictViewIterType<T>*>(self);
     if (!sdvi->should_raise_stop_iteration)
     {
+        PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(sdvi->sd));
+        sdvi->follow();
         sdvi->untrack(sdvi->it);
-        --sdvi->sd->known_referrers;
-        Py_DECREF(sdvi->sd);
+        sdvi->track_end();
     }
-    Py_TYPE(self)->tp_free(self);
+    Py_DECREF(sdvi->sd);
+    Py_XDECREF(sdvi->stop.ob);
+    Py_XDECREF(sdvi->result);
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
 }
 
 template<>
 PyObject* SortedDictViewIterType<FwdIterType>::next(void)
 {
+    PyCriticalSection2Locker _(reinterpret_cast<PyObject*>(this), reinterpret_cast<PyObject*>(this->sd));
     if (this->should_raise_stop_iteration)
     {
         return nullptr;
     }
+    this->follow();
 
     return this->next_when_has_next();
 }
@@ -145,16 +241,19 @@ PyObject* SortedDictViewIterType<FwdIterType>::next(void)
 template<>
 PyObject* SortedDictViewIterType<RevIterType>::next(void)
 {
+    PyCriticalSection2Locker _(reinterpret_cast<PyObject*>(this), reinterpret_cast<PyObject*>(this->sd));
     if (this->should_raise_stop_iteration)
     {
         return nullptr;
     }
+    this->follow();
 
     // Since a reverse iterator is anchored by its underlying forward iterator,
     // a strategic sequence of erasures (for instance, erasing the first
     // key-value pair when it was referencing the same pair) may result in it
-    // not currently referencing any key-value pair.
-    if (this->it == this->sd->map->rend())
+    // not currently referencing any key-value pair, or referencing one beyond
+    // the key at which iteration stops.
+    if (!this->has_next(this->it))
     {
         this->untrack(this->it);
         this->track_end();
@@ -171,32 +270,136 @@ PyObject* SortedDictViewIterType<T>::next_when_has_next(void)
     T curr = this->it++;
     this->untrack(curr);
     this->track(this->it);
+#ifndef Py_GIL_DISABLED
+    // If the caller has released the previous result, no one else can observe
+    // it being overwritten. (On a free-threaded build, the reference count
+    // does not reliably indicate that, so results are never reused.)
+    if (this->iterator_into_object != nullptr)
+    {
+        if (this->result != nullptr && Py_REFCNT(this->result) == 1)
+        {
+            this->iterator_into_object(curr, this->result);
+            return Py_NewRef(this->result);  // 🆕
+        }
+        PyObject* ob = this->iterator_to_object(curr);  // 🆕
+        if (ob != nullptr)
+        {
+            Py_XSETREF(this->result, Py_NewRef(ob));
+        }
+        return ob;
+    }
+#endif
     return this->iterator_to_object(curr);
 }
 
-template<>
-PyObject* SortedDictViewIterType<FwdIterType>::New(
-    PyTypeObject* type, SortedDictType* sd, IteratorToObject<FwdIterType> forward_iterator_to_object
-)
+/**
+ * Retrieve as many of the next elements as possible, up to the given number.
+ * On failure, set a Python exception.
+ *
+ * Unlike `next`, which moves the lock this iterator holds on a key-value pair
+ * every time it is called, this moves the lock only once.
+ *
+ * @param chunk_size Maximum number of elements.
+ *
+ * @return List of elements (empty if iteration has stopped) if successful,
+ * else `nullptr`.
+ */
+template<typename T>
+PyObject* SortedDictViewIterType<T>::next_chunk(PyObject* chunk_size)
 {
-    PyObject* self = type->tp_alloc(type, 0);  // 🆕
-    if (self == nullptr)
+    Py_ssize_t chunk_size_ = PyNumber_AsSsize_t(chunk_size, PyExc_OverflowError);
+    if (chunk_size_ == -1 && PyErr_Occurred() != nullptr)
     {
         return nullptr;
     }
+    if (chunk_size_ < 0)
+    {
+        PyErr_Format(PyExc_ValueError, "got chunk size %zd, want non-negative chunk size", chunk_size_);
+        return nullptr;
+    }
 
-    SortedDictViewIterType<FwdIterType>* sdvi = reinterpret_cast<SortedDictViewIterType<FwdIterType>*>(self);
-    sdvi->sd = sd;
-    sdvi->it = sdvi->sd->map->begin();
-    sdvi->track(sdvi->it);
-    sdvi->iterator_to_object = forward_iterator_to_object;
-    return self;
+    PyCriticalSection2Locker _(reinterpret_cast<PyObject*>(this), reinterpret_cast<PyObject*>(this->sd));
+    if (this->should_raise_stop_iteration || chunk_size_ == 0)
+    {
+        return PyList_New(0);  // 🆕
+    }
+    Py_ssize_t sz = this->sd->len();
+    if (sz == -1)
+    {
+        return nullptr;
+    }
+    this->follow();
+
+    Py_ssize_t capacity = std::min(chunk_size_, sz);
+    PyObjectWrapper chunk(PyList_New(capacity));  // 🆕
+    if (chunk == nullptr)
+    {
+        return nullptr;
+    }
+
+    // The key-value pair the iterator references at the start remains locked
+    // until the end, so that the iterator can always be restored to a valid
+    // state.
+    T first = this->it;
+    Py_ssize_t chunk_len = 0;
+    for (; chunk_len < capacity && this->has_next(this->it); ++chunk_len, ++this->it)
+    {
+        PyObject* ob = this->iterator_to_object(this->it);  // 🆕
+        if (ob == nullptr)
+        {
+            break;
+        }
+        PyList_SET_ITEM(chunk.get(), chunk_len, ob);
+    }
+    this->untrack(first);
+    this->track(this->it);
+    if (PyErr_Occurred() != nullptr)
+    {
+        return nullptr;
+    }
+    if (chunk_len < capacity && PyList_SetSlice(chunk.get(), chunk_len, capacity, nullptr) != 0)
+    {
+        return nullptr;
+    }
+    return chunk.release();
+}
+
+template<>
+PyObject* SortedDictViewIterType<FwdIterType>::New(
+    PyTypeObject* type, SortedDictType* sd, IteratorToObject<FwdIterType> forward_iterator_to_object
+)
+{
+    return New(type, sd, forward_iterator_to_object, sd->map->begin(), nullptr, false);
 }
 
 template<>
 PyObject* SortedDictViewIterType<RevIterType>::New(
     PyTypeObject* type, SortedDictType* sd, IteratorToObject<RevIterType> reverse_iterator_to_object
 )
+{
+    return New(type, sd, reverse_iterator_to_object, sd->map->rbegin(), nullptr, false);
+}
+
+/**
+ * Create an iterator over the given sorted dictionary.
+ *
+ * @param type Iterator type.
+ * @param sd Sorted dictionary.
+ * @param iterator_to_object Function to convert a C++ iterator into a Python
+ * object.
+ * @param it C++ iterator to start at.
+ * @param stop Key beyond which iteration stops, or `nullptr` to iterate until
+ * the end.
+ * @param stop_inclusive Whether iteration stops after (as opposed to before)
+ * the key beyond which it stops.
+ *
+ * @return Iterator if successful, else `nullptr`.
+ */
+template<typename T>
+PyObject* SortedDictViewIterType<T>::New(
+    PyTypeObject* type, SortedDictType* sd, IteratorToObject<T> iterator_to_object, T it, PyObject* stop,
+    bool stop_inclusive
+)
 {
     PyObject* self = type->tp_alloc(type, 0);  // 🆕
     if (self == nullptr)
@@ -204,11 +407,19 @@ PyObject* SortedDictViewIterType<RevIterType>::New(
         return nullptr;
     }
 
-    SortedDictViewIterType<RevIterType>* sdvi = reinterpret_cast<SortedDictViewIterType<RevIterType>*>(self);
+    SortedDictViewIterType<T>* sdvi = reinterpret_cast<SortedDictViewIterType<T>*>(self);
     sdvi->sd = sd;
-    sdvi->it = sdvi->sd->map->rbegin();
+    Py_INCREF(sdvi->sd);  // 🆕
+    sdvi->it = it;
+    if (stop != nullptr)
+    {
+        sdvi->stop = SortedDictKey(stop, sd->state);
+        Py_INCREF(stop);  // 🆕
+    }
+    sdvi->stop_inclusive = stop_inclusive;
+    sdvi->track_begin();
     sdvi->track(sdvi->it);
-    sdvi->iterator_to_object = reverse_iterator_to_object;
+    sdvi->iterator_to_object = iterator_to_object;
     return self;
 }
 
@@ -225,18 +436,7 @@ PyObject* SortedDictViewType::getitem(Py_ssize_t position)
         PyErr_Format(PyExc_IndexError, "got invalid index %zd for view of length %zd", position, sz);
         return nullptr;
     }
-    FwdIterType it;
-    if (positive_position <= sz / 2)
-    {
-        it = this->sd->map->begin();
-        std::advance(it, positive_position);
-    }
-    else
-    {
-        it = this->sd->map->end();
-        std::advance(it, positive_position - sz);
-    }
-    return this->forward_iterator_to_object(it);
+    return this->forward_iterator_to_object(this->sd->map->nth(positive_position));
 }
 
 PyObject* SortedDictViewType::getitem(Py_ssize_t start, Py_ssize_t stop, Py_ssize_t step)
@@ -248,56 +448,26 @@ PyObject* SortedDictViewType::getitem(Py_ssize_t start, Py_ssize_t stop, Py_ssiz
     }
     Py_ssize_t slice_len = PySlice_AdjustIndices(sz, &start, &stop, step);
     PyObject* lst = PyList_New(slice_len);  // 🆕
-    if (slice_len == 0)
+    if (lst == nullptr || slice_len == 0)
     {
         return lst;
     }
 
-    FwdIterType it;
-    if ((step > 0 && start <= sz - stop) || (step < 0 && sz - 1 - start < stop + 1))
+    FwdIterType it = this->sd->map->nth(start);
+    for (Py_ssize_t i = 0;; ++i)
     {
-        if (step > 0)
-        {
-            it = this->sd->map->begin();
-            std::advance(it, start);
-        }
-        else
-        {
-            it = this->sd->map->end();
-            std::advance(it, start - sz);
-        }
-        for (Py_ssize_t i = 0;; ++i)
+        PyObject* ob = this->forward_iterator_to_object(it);  // 🆕
+        if (ob == nullptr)
         {
-            PyList_SET_ITEM(lst, i, this->forward_iterator_to_object(it));
-            if (i == slice_len - 1)
-            {
-                break;
-            }
-            std::advance(it, step);
-        }
-    }
-    else
-    {
-        start += (slice_len - 1) * step;
-        if (step > 0)
-        {
-            it = this->sd->map->end();
-            std::advance(it, start - sz);
-        }
-        else
-        {
-            it = this->sd->map->begin();
-            std::advance(it, start);
+            Py_DECREF(lst);
+            return nullptr;
         }
-        for (Py_ssize_t i = slice_len - 1;; --i)
+        PyList_SET_ITEM(lst, i, ob);
+        if (i == slice_len - 1)
         {
-            PyList_SET_ITEM(lst, i, this->forward_iterator_to_object(it));
-            if (i == 0)
-            {
-                break;
-            }
-            std::advance(it, -step);
+            break;
         }
+        it = this->sd->map->advance(it, step);
     }
     return lst;
 }
@@ -306,7 +476,9 @@ void SortedDictViewType::Delete(PyObject* self)
 {
     SortedDictViewType* sdv = reinterpret_cast<SortedDictViewType*>(self);
     Py_DECREF(sdv->sd);
-    Py_TYPE(self)->tp_free(self);
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
 }
 
 PyObject* SortedDictViewType::repr(PyObject* ob)
@@ -323,11 +495,13 @@ PyObject* SortedDictViewType::repr(PyObject* ob)
 
 Py_ssize_t SortedDictViewType::len(void)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     return this->sd->len();
 }
 
 PyObject* SortedDictViewType::getitem(PyObject* idx)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     if (PyIndex_Check(idx))
     {
         Py_ssize_t position = PyNumber_AsSsize_t(idx, PyExc_IndexError);
@@ -357,11 +531,13 @@ PyObject* SortedDictViewType::getitem(PyObject* idx)
 
 PyObject* SortedDictViewType::iter(PyTypeObject* type)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     return SortedDictViewIterType<FwdIterType>::New(type, this->sd, this->forward_iterator_to_object);
 }
 
 PyObject* SortedDictViewType::reversed(PyTypeObject* type)
 {
+    PyCriticalSectionLocker _(reinterpret_cast<PyObject*>(this->sd));
     return SortedDictViewIterType<RevIterType>::New(type, this->sd, this->reverse_iterator_to_object);
 }
 
@@ -3,13 +3,15 @@
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
-#include <map>
 
 #include "sorted_dict_type.hh"
 
 template<typename T>
 using IteratorToObject = PyObject* (*)(T);
 
+template<typename T>
+using IteratorIntoObject = void (*)(T, PyObject*);
+
 template<typename T>
 struct SortedDictViewIterType
 {
@@ -17,24 +19,42 @@ public:
     PyObject_HEAD;
 
 protected:
+    // Held until deallocation (even after iteration stops), so that it can
+    // always be locked along with this iterator.
     SortedDictType* sd;
     T it;
     bool should_raise_stop_iteration;
 
+    // Key beyond which iteration stops, if any, and whether iteration stops
+    // after it (as opposed to before it).
+    SortedDictKey stop;
+    bool stop_inclusive;
+
     // See below for why this is required.
     IteratorToObject<T> iterator_to_object;
 
+    // Object most recently returned, and function to overwrite it in place
+    // with the object a C++ iterator converts into. If the latter is set, the
+    // former is reused whenever this iterator holds the only reference to it.
+    PyObject* result;
+    IteratorIntoObject<T> iterator_into_object;
+
 private:
     void track(T);
     void track_begin(void);
     void track_end(void);
     void untrack(T);
+    void follow(void);
+    bool is_beyond_stop(T);
+    bool has_next(T);
     PyObject* next_when_has_next(void);
 
 public:
     static void Delete(PyObject*);
     PyObject* next(void);
+    PyObject* next_chunk(PyObject*);
     static PyObject* New(PyTypeObject*, SortedDictType*, IteratorToObject<T>);
+    static PyObject* New(PyTypeObject*, SortedDictType*, IteratorToObject<T>, T, PyObject*, bool);
 };
 
 struct SortedDictViewType
@@ -1,4 +1,5 @@
 import bisect
+import pickle
 import re
 import string
 import sys
@@ -17,7 +18,7 @@ from hypothesis import strategies as st
 from hypothesis.stateful import RuleBasedStateMachine, invariant, precondition, rule
 from hypothesis.strategies import SearchStrategy
 
-from pysorteddict import SortedDict
+from pysorteddict import FrozenSortedDict, SortedDict
 
 settings.register_profile("default", max_examples=300, stateful_step_count=150)
 
@@ -28,6 +29,7 @@ strategy_mapping = {
     float: st.floats(allow_nan=False),
     int: st.integers(),
     str: st.text(alphabet=string.printable),
+    tuple: st.tuples(st.text(alphabet=string.printable), st.integers()),
     date: st.dates(),
     timedelta: st.timedeltas(),
     Decimal: st.decimals(allow_nan=False),
@@ -50,10 +52,13 @@ strategy_mapping_complement = {
     for tp in strategy_mapping
 }
 supported_key_types = st.sampled_from([*strategy_mapping])
-unsupported_key_types = st.sampled_from([bytearray, list, memoryview, tuple])
+unsupported_key_types = st.sampled_from([bytearray, frozenset, list, memoryview])
 supported_keys = st.one_of(strategy_mapping.values())
-unsupported_keys = st.tuples(st.floats(), st.integers())
+unsupported_keys = st.frozensets(st.integers())
 all_keys = st.one_of(supported_keys, unsupported_keys)
+nearest_methods = st.sampled_from(
+    [f"{direction}_{kind}" for direction in ("ceiling", "floor", "higher", "lower") for kind in ("item", "key")]
+)
 
 
 def prec_key_type_not_set(self) -> bool:
@@ -68,6 +73,18 @@ def prec_key_type_admits_nan(self) -> bool:
     return any(self.key_type is key_type for key_type in [float, Decimal])
 
 
+def prec_key_type_numeric(self) -> bool:
+    return any(self.key_type is key_type for key_type in [float, int])
+
+
+def prec_key_type_set_not_numeric(self) -> bool:
+    return prec_key_type_set(self) and not prec_key_type_numeric(self)
+
+
+def prec_keys_empty(self) -> bool:
+    return not self.sorted_keys
+
+
 def prec_keys_not_empty(self) -> bool:
     return bool(self.sorted_keys)
 
@@ -84,6 +101,10 @@ def prec_inactive_iterators_not_empty(self) -> bool:
     return bool(self.inactive_iterators)
 
 
+def prec_snapshots_not_empty(self) -> bool:
+    return bool(self.snapshots)
+
+
 def prec_active_iterators_locked_no_keys(self) -> bool:
     return all(iterator.locked_key is None for iterator in self.active_iterators)
 
@@ -265,6 +286,31 @@ class IteratorWrapper:
             self.active = False
         return next_key, observed
 
+    def next_chunk(self, chunk_size):
+        # It shall be an error to call this method on inactive iterators.
+        observed = self.iterator.next_chunk(chunk_size)
+        if chunk_size == 0:
+            return [], observed
+        if self.fwd:
+            idx = bisect.bisect_left(self.sorted_keys, self.locked_key)
+            next_keys = self.sorted_keys[idx : idx + chunk_size]
+            try:
+                self.locked_key = self.sorted_keys[idx + chunk_size]
+            except IndexError:
+                self.active = False
+            return next_keys, observed
+        if self.locked_key is None:
+            idx = len(self.sorted_keys)
+        else:
+            idx = bisect.bisect_left(self.sorted_keys, self.locked_key)
+        next_keys = self.sorted_keys[max(idx - chunk_size, 0) : idx][::-1]
+        if next_keys:
+            self.locked_key = next_keys[-1]
+        if idx <= chunk_size:
+            # All keys have been yielded.
+            self.active = False
+        return next_keys, observed
+
 
 class FuzzMachine(RuleBasedStateMachine):
     def __init__(self):
@@ -281,6 +327,7 @@ class FuzzMachine(RuleBasedStateMachine):
         self.sorted_dict_values = self.sorted_dict.values()
         self.active_iterators = []
         self.inactive_iterators = []
+        self.snapshots = []
 
     def key_to_item_or_key_or_value(self, key, obj):
         obj_class_name = obj.__class__.__name__
@@ -320,6 +367,9 @@ class FuzzMachine(RuleBasedStateMachine):
 
         assert self.sorted_dict.key_type is self.key_type
 
+        for snapshot, snapshot_repr in self.snapshots:
+            assert repr(snapshot) == snapshot_repr
+
         # It is useful to have a list of the keys. Instead of updating it
         # constantly, just do it here.
         self.sorted_keys[:] = [*sorted_normal_dict]
@@ -601,6 +651,356 @@ class FuzzMachine(RuleBasedStateMachine):
         with pytest.raises(StopIteration):
             next(iterator.iterator)
 
+    @precondition(prec_active_iterators_not_empty)
+    @rule(iterator=rule_active_iterator(), chunk_size=st.integers(min_value=0, max_value=10))
+    def next_chunk_active(self, iterator, chunk_size):
+        next_keys, observed = iterator.next_chunk(chunk_size)
+        assert observed == [self.key_to_item_or_key_or_value(key, iterator.iterator) for key in next_keys]
+
+    @precondition(prec_inactive_iterators_not_empty)
+    @rule(iterator=rule_inactive_iterator(), chunk_size=st.integers(min_value=0, max_value=sys.maxsize))
+    def next_chunk_inactive(self, iterator, chunk_size):
+        assert iterator.iterator.next_chunk(chunk_size) == []
+
+    @precondition(prec_active_iterators_not_empty)
+    @rule(iterator=rule_active_iterator(), chunk_size=st.integers(min_value=-sys.maxsize - 1, max_value=-1))
+    def next_chunk_value_error(self, iterator, chunk_size):
+        with pytest.raises(ValueError, match=f"got chunk size {chunk_size}, want non-negative chunk size"):
+            iterator.iterator.next_chunk(chunk_size)
+
+    ###########################################################################
+    # `reduce` and `setstate`.
+    ###########################################################################
+
+    @rule(protocol=st.integers(min_value=0, max_value=pickle.HIGHEST_PROTOCOL))
+    def pickle_and_unpickle(self, protocol):
+        self.sorted_dict = pickle.loads(pickle.dumps(self.sorted_dict, protocol))
+        self.sorted_dict_items = self.sorted_dict.items()
+        self.sorted_dict_keys = self.sorted_dict.keys()
+        self.sorted_dict_values = self.sorted_dict.values()
+        self.active_iterators.clear()
+        self.inactive_iterators.clear()
+
+    @rule(state=st.sampled_from([None, (), (int, [], [], None, None)]))
+    def setstate_wrong_state(self, state):
+        with pytest.raises(TypeError, match=re.escape(f"got state {state!r}, want tuple of length 3 or 4")):
+            self.sorted_dict.__setstate__(state)
+
+    @rule(key_func=st.sampled_from([0, "key", ()]))
+    def setstate_wrong_key_function(self, key_func):
+        with pytest.raises(TypeError, match=re.escape(f"got key function {key_func!r} of type {type(key_func)!r}")):
+            self.sorted_dict.__setstate__((int, [], [], key_func))
+        assert self.sorted_dict.key is None
+
+    ###########################################################################
+    # `to_buffer`.
+    ###########################################################################
+
+    @precondition(prec_key_type_not_set)
+    @rule()
+    def to_buffer_key_type_not_set(self):
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict_keys.to_buffer()
+
+    @precondition(prec_key_type_set_not_numeric)
+    @rule()
+    def to_buffer_wrong_key_type(self):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key type {self.key_type}, want key type {float} or {int}")
+        ):
+            self.sorted_dict_keys.to_buffer()
+
+    @precondition(prec_key_type_numeric)
+    @rule()
+    def to_buffer(self):
+        big_keys = [key for key in self.sorted_keys if self.key_type is int and not -(2**63) <= key < 2**63]
+        if big_keys:
+            with pytest.raises(
+                OverflowError, match=re.escape(f"got key {big_keys[0]!r}, want key which fits in 64 bits")
+            ):
+                self.sorted_dict_keys.to_buffer()
+            return
+        buffer = self.sorted_dict_keys.to_buffer()
+        assert buffer.format == ("d" if self.key_type is float else "q")
+        assert buffer.tolist() == self.sorted_keys
+
+    ###########################################################################
+    # `bisect_left`, `bisect_right` and `index`.
+    ###########################################################################
+
+    @precondition(prec_key_type_not_set)
+    @rule(method=st.sampled_from(("bisect_left", "bisect_right", "index")), key=all_keys)
+    def rank_key_type_not_set(self, method, key):
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_set)
+    @rule(method=st.sampled_from(("bisect_left", "bisect_right", "index")), key=rule_key_wrong_type())
+    def rank_wrong_type(self, method, key):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_admits_nan)
+    @rule(method=st.sampled_from(("bisect_left", "bisect_right", "index")), key=rule_key_is_nan())
+    def rank_nan(self, method, key):
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_right_type())
+    def rank_probably_key_error(self, key):
+        assert self.sorted_dict.bisect_left(key) == bisect.bisect_left(self.sorted_keys, key)
+        assert self.sorted_dict.bisect_right(key) == bisect.bisect_right(self.sorted_keys, key)
+        if key not in self.normal_dict:
+            with pytest.raises(KeyError, match=re.escape(f"{key!r}")):
+                self.sorted_dict.index(key)
+        else:
+            assert self.sorted_dict.index(key) == self.sorted_keys.index(key)
+
+    @precondition(prec_keys_not_empty)
+    @rule(key=rule_key_exists())
+    def rank(self, key):
+        position = self.sorted_keys.index(key)
+        assert self.sorted_dict.bisect_left(key) == position
+        assert self.sorted_dict.bisect_right(key) == position + 1
+        assert self.sorted_dict.index(key) == position
+
+    ###########################################################################
+    # `ceiling_item`, `ceiling_key`, `floor_item`, `floor_key`, `higher_item`,
+    # `higher_key`, `lower_item` and `lower_key`.
+    ###########################################################################
+
+    def nearest_key(self, method, key):
+        if method.startswith("ceiling"):
+            position = bisect.bisect_left(self.sorted_keys, key)
+        elif method.startswith("floor"):
+            position = bisect.bisect_right(self.sorted_keys, key) - 1
+        elif method.startswith("higher"):
+            position = bisect.bisect_right(self.sorted_keys, key)
+        else:
+            position = bisect.bisect_left(self.sorted_keys, key) - 1
+        if 0 <= position < len(self.sorted_keys):
+            return self.sorted_keys[position]
+        return None
+
+    def nearest(self, method, key):
+        nearest_key = self.nearest_key(method, key)
+        if nearest_key is None or method.endswith("key"):
+            return nearest_key
+        return nearest_key, self.normal_dict[nearest_key]
+
+    @precondition(prec_key_type_not_set)
+    @rule(method=nearest_methods, key=all_keys)
+    def nearest_key_type_not_set(self, method, key):
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_set)
+    @rule(method=nearest_methods, key=rule_key_wrong_type())
+    def nearest_wrong_type(self, method, key):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_admits_nan)
+    @rule(method=nearest_methods, key=rule_key_is_nan())
+    def nearest_nan(self, method, key):
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            getattr(self.sorted_dict, method)(key)
+
+    @precondition(prec_key_type_set)
+    @rule(method=nearest_methods, key=rule_key_right_type())
+    def nearest_probably_none(self, method, key):
+        assert getattr(self.sorted_dict, method)(key) == self.nearest(method, key)
+
+    @precondition(prec_keys_not_empty)
+    @rule(method=nearest_methods, key=rule_key_exists())
+    def nearest_existing(self, method, key):
+        assert getattr(self.sorted_dict, method)(key) == self.nearest(method, key)
+
+    ###########################################################################
+    # `irange`.
+    ###########################################################################
+
+    @precondition(prec_key_type_not_set)
+    @rule(key=all_keys, reverse=st.booleans())
+    def irange_key_type_not_set(self, key, reverse):
+        assert [*self.sorted_dict.irange(reverse=reverse)] == []
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict.irange(key, reverse=reverse)
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict.irange(hi=key, reverse=reverse)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_wrong_type(), reverse=st.booleans())
+    def irange_wrong_type(self, key, reverse):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.irange(key, reverse=reverse)
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.irange(hi=key, reverse=reverse)
+
+    @precondition(prec_key_type_admits_nan)
+    @rule(key=rule_key_is_nan(), reverse=st.booleans())
+    def irange_nan(self, key, reverse):
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            self.sorted_dict.irange(key, reverse=reverse)
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            self.sorted_dict.irange(hi=key, reverse=reverse)
+
+    @rule(inclusive=st.sampled_from([(), (True,), (True, True, True), None]))
+    def irange_wrong_call(self, inclusive):
+        with pytest.raises(TypeError):
+            self.sorted_dict.irange(inclusive=inclusive)
+
+    def irange_check(self, lo, hi, inclusive, reverse):
+        expected = [
+            key
+            for key in self.sorted_keys
+            if (lo is None or lo < key or inclusive[0] and lo == key)
+            and (hi is None or key < hi or inclusive[1] and key == hi)
+        ]
+        if reverse:
+            expected.reverse()
+        assert [*self.sorted_dict.irange(lo, hi, inclusive, reverse)] == expected
+
+    @precondition(prec_key_type_set)
+    @rule(
+        lo=st.one_of(st.none(), rule_key_right_type()),
+        hi=st.one_of(st.none(), rule_key_right_type()),
+        inclusive=st.tuples(st.booleans(), st.booleans()),
+        reverse=st.booleans(),
+    )
+    def irange_probably_empty(self, lo, hi, inclusive, reverse):
+        self.irange_check(lo, hi, inclusive, reverse)
+
+    @precondition(prec_keys_not_empty)
+    @rule(
+        lo=rule_key_exists(),
+        hi=rule_key_exists(),
+        inclusive=st.tuples(st.booleans(), st.booleans()),
+        reverse=st.booleans(),
+    )
+    def irange(self, lo, hi, inclusive, reverse):
+        self.irange_check(lo, hi, inclusive, reverse)
+
+    ###########################################################################
+    # `delete_range`.
+    ###########################################################################
+
+    @precondition(prec_key_type_not_set)
+    @rule(key=all_keys)
+    def delete_range_key_type_not_set(self, key):
+        self.sorted_dict.delete_range()
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict.delete_range(key)
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict.delete_range(hi=key)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_wrong_type())
+    def delete_range_wrong_type(self, key):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.delete_range(key)
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.delete_range(hi=key)
+
+    @precondition(prec_key_type_admits_nan)
+    @rule(key=rule_key_is_nan())
+    def delete_range_nan(self, key):
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            self.sorted_dict.delete_range(key)
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            self.sorted_dict.delete_range(hi=key)
+
+    @rule(inclusive=st.sampled_from([(), (True,), (True, True, True), None]))
+    def delete_range_wrong_call(self, inclusive):
+        with pytest.raises(TypeError):
+            self.sorted_dict.delete_range(inclusive=inclusive)
+
+    def delete_keys_check(self, keys, delete):
+        locked_keys = {iterator.locked_key for iterator in self.active_iterators if iterator.locked_key is not None}
+        if locked_keys.intersection(keys):
+            with pytest.raises(
+                RuntimeError, match=r"operation not permitted: key-value pair locked by [\d]+ iterator\(s\)"
+            ):
+                delete()
+            return
+        for key in keys:
+            del self.normal_dict[key]
+        delete()
+
+    def delete_range_check(self, lo, hi, inclusive):
+        keys = [
+            key
+            for key in self.sorted_keys
+            if (lo is None or lo < key or inclusive[0] and lo == key)
+            and (hi is None or key < hi or inclusive[1] and key == hi)
+        ]
+        self.delete_keys_check(keys, lambda: self.sorted_dict.delete_range(lo, hi, inclusive))
+
+    @precondition(prec_key_type_set)
+    @rule(
+        lo=st.one_of(st.none(), rule_key_right_type()),
+        hi=st.one_of(st.none(), rule_key_right_type()),
+        inclusive=st.tuples(st.booleans(), st.booleans()),
+    )
+    def delete_range_probably_empty(self, lo, hi, inclusive):
+        self.delete_range_check(lo, hi, inclusive)
+
+    @precondition(prec_keys_not_empty)
+    @rule(lo=rule_key_exists(), hi=rule_key_exists(), inclusive=st.tuples(st.booleans(), st.booleans()))
+    def delete_range(self, lo, hi, inclusive):
+        self.delete_range_check(lo, hi, inclusive)
+
+    ###########################################################################
+    # `delitem` for the sorted dictionary keys.
+    ###########################################################################
+
+    @rule(idx=st.one_of(st.integers(), st.slices(10)), value=st.integers())
+    def delitem2_keys_assign(self, idx, value):
+        with pytest.raises(TypeError, match="object does not support item assignment"):
+            self.sorted_dict_keys[idx] = value
+
+    @rule()
+    def delitem2_keys_wrong_call(self):
+        with pytest.raises(TypeError, match="got index None of type <class 'NoneType'>"):
+            del self.sorted_dict_keys[None]
+
+    @rule(idx=rule_invalid_position())
+    def delitem2_keys_index_error(self, idx):
+        with pytest.raises(IndexError, match=f"got invalid index {idx} for view of length {len(self.sorted_keys)}"):
+            del self.sorted_dict_keys[idx]
+
+    @precondition(prec_keys_not_empty)
+    @rule(idx=rule_valid_position())
+    def delitem2_keys_position(self, idx):
+        keys = [self.sorted_keys[idx]]
+
+        def delete():
+            del self.sorted_dict_keys[idx]
+
+        self.delete_keys_check(keys, delete)
+
+    @rule(idx=rule_valid_slice())
+    def delitem2_keys_slice(self, idx):
+        keys = self.sorted_keys[idx]
+
+        def delete():
+            del self.sorted_dict_keys[idx]
+
+        self.delete_keys_check(keys, delete)
+
     ###########################################################################
     # `clear`.
     ###########################################################################
@@ -634,6 +1034,52 @@ class FuzzMachine(RuleBasedStateMachine):
         self.active_iterators.clear()
         self.inactive_iterators.clear()
 
+    ###########################################################################
+    # `FrozenSortedDict`.
+    ###########################################################################
+
+    @rule()
+    def frozen(self):
+        frozen_sorted_dict = FrozenSortedDict(self.sorted_dict)
+        sorted_normal_dict = dict(sorted(self.normal_dict.items()))
+        assert repr(frozen_sorted_dict) == f"FrozenSortedDict({sorted_normal_dict})"
+        assert len(frozen_sorted_dict) == len(sorted_normal_dict)
+        assert frozen_sorted_dict.keys() == (*sorted_normal_dict,)
+        assert frozen_sorted_dict.values() == (*sorted_normal_dict.values(),)
+        assert frozen_sorted_dict.items() == (*sorted_normal_dict.items(),)
+        assert [*reversed(frozen_sorted_dict)] == [*sorted_normal_dict][::-1]
+        assert frozen_sorted_dict.key_type is self.key_type
+        for idx, (key, value) in enumerate(sorted_normal_dict.items()):
+            assert key in frozen_sorted_dict
+            assert frozen_sorted_dict[key] == frozen_sorted_dict.get(key) == value
+            assert frozen_sorted_dict.index(key) == frozen_sorted_dict.bisect_left(key) == idx
+            assert frozen_sorted_dict.bisect_right(key) == idx + 1
+        other = FrozenSortedDict(self.normal_dict)
+        assert frozen_sorted_dict == other
+        assert hash(frozen_sorted_dict) == hash(other)
+        assert pickle.loads(pickle.dumps(frozen_sorted_dict)) == frozen_sorted_dict
+        assert FrozenSortedDict(frozen_sorted_dict) is frozen_sorted_dict
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_wrong_type())
+    def frozen_wrong_type(self, key):
+        frozen_sorted_dict = FrozenSortedDict(self.sorted_dict)
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            frozen_sorted_dict.get(key)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_right_type())
+    def frozen_probably_key_error(self, key):
+        frozen_sorted_dict = FrozenSortedDict(self.sorted_dict)
+        if key not in self.normal_dict:
+            assert frozen_sorted_dict.get(key, frozen_sorted_dict) is frozen_sorted_dict
+            with pytest.raises(KeyError, match=re.escape(f"{key!r}")):
+                frozen_sorted_dict[key]
+        else:
+            assert frozen_sorted_dict[key] == self.normal_dict[key]
+
     ###########################################################################
     # `get`.
     ###########################################################################
@@ -675,6 +1121,117 @@ class FuzzMachine(RuleBasedStateMachine):
         assert self.sorted_dict.get(key) == self.normal_dict.get(key)
         assert self.sorted_dict.get(key, value) == self.normal_dict.get(key, value)
 
+    ###########################################################################
+    # `peekitem`.
+    ###########################################################################
+
+    @rule(args=st.sampled_from([(object,), (0, 0)]))
+    def peekitem_wrong_call(self, args):
+        with pytest.raises(TypeError):
+            self.sorted_dict.peekitem(*args)
+
+    @rule(idx=rule_invalid_position())
+    def peekitem_index_error(self, idx):
+        with pytest.raises(
+            IndexError, match=f"got invalid index {idx} for sorted dictionary of length {len(self.sorted_keys)}"
+        ):
+            self.sorted_dict.peekitem(idx)
+
+    @precondition(prec_keys_not_empty)
+    @rule(idx=rule_valid_position())
+    def peekitem(self, idx):
+        key = self.sorted_keys[idx]
+        assert self.sorted_dict.peekitem(idx) == (key, self.normal_dict[key])
+        key = self.sorted_keys[-1]
+        assert self.sorted_dict.peekitem() == (key, self.normal_dict[key])
+
+    ###########################################################################
+    # `pop`.
+    ###########################################################################
+
+    @rule(args=st.sampled_from([(), (object, object, object)]))
+    def pop_wrong_call(self, args):
+        with pytest.raises(TypeError, match=re.escape(f"pop() takes 1 to 2 positional arguments ({len(args)} given)")):
+            self.sorted_dict.pop(*args)
+
+    @precondition(prec_key_type_not_set)
+    @rule(key=all_keys)
+    def pop_key_type_not_set(self, key):
+        with pytest.raises(RuntimeError, match="key type not set: insert at least one item first"):
+            self.sorted_dict.pop(key)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_wrong_type())
+    def pop_wrong_type(self, key):
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.pop(key)
+
+    @precondition(prec_key_type_admits_nan)
+    @rule(key=rule_key_is_nan())
+    def pop_nan(self, key):
+        with pytest.raises(ValueError, match=re.escape(f"got bad key {key!r} of type {type(key)}")):
+            self.sorted_dict.pop(key)
+
+    @precondition(prec_key_type_set)
+    @rule(key=rule_key_right_type(), value=st.integers())
+    def pop_probably_key_error(self, key, value):
+        if key not in self.normal_dict:
+            with pytest.raises(KeyError, match=re.escape(f"{key!r}")):
+                self.sorted_dict.pop(key)
+            assert self.sorted_dict.pop(key, value) == value
+
+    @precondition(prec_active_iterators_locked_some_keys)
+    @rule(key=rule_locked_key())
+    def pop_runtime_error(self, key):
+        with pytest.raises(
+            RuntimeError, match=r"operation not permitted: key-value pair locked by [\d]+ iterator\(s\)"
+        ):
+            self.sorted_dict.pop(key)
+
+    @precondition(prec_active_iterators_locked_not_all_keys)
+    @rule(key=rule_unlocked_key(), value=st.integers())
+    def pop(self, key, value):
+        assert self.sorted_dict.pop(key, value) == self.normal_dict.pop(key)
+
+    ###########################################################################
+    # `popitem`.
+    ###########################################################################
+
+    @rule(args=st.sampled_from([(object,), (0, 0)]))
+    def popitem_wrong_call(self, args):
+        with pytest.raises(TypeError):
+            self.sorted_dict.popitem(*args)
+
+    @precondition(prec_keys_empty)
+    @rule()
+    def popitem_key_error(self):
+        with pytest.raises(KeyError, match=re.escape("popitem(): sorted dictionary is empty")):
+            self.sorted_dict.popitem()
+
+    @precondition(prec_keys_not_empty)
+    @rule(idx=rule_invalid_position())
+    def popitem_index_error(self, idx):
+        with pytest.raises(
+            IndexError, match=f"got invalid index {idx} for sorted dictionary of length {len(self.sorted_keys)}"
+        ):
+            self.sorted_dict.popitem(idx)
+
+    @precondition(prec_keys_not_empty)
+    @rule(idx=st.one_of(st.none(), rule_valid_position()))
+    def popitem(self, idx):
+        key = self.sorted_keys[-1 if idx is None else idx]
+        locked_keys = {iterator.locked_key for iterator in self.active_iterators if iterator.locked_key is not None}
+        args = () if idx is None else (idx,)
+        if key in locked_keys:
+            with pytest.raises(
+                RuntimeError, match=r"operation not permitted: key-value pair locked by [\d]+ iterator\(s\)"
+            ):
+                self.sorted_dict.popitem(*args)
+            return
+        assert self.sorted_dict.popitem(*args) == (key, self.normal_dict.pop(key))
+
     ###########################################################################
     # `setdefault`.
     ###########################################################################
@@ -721,6 +1278,30 @@ class FuzzMachine(RuleBasedStateMachine):
     def setdefault_existing(self, key):
         assert self.sorted_dict.setdefault(key) == self.normal_dict.setdefault(key)
 
+    ###########################################################################
+    # `snapshot`.
+    ###########################################################################
+
+    @rule()
+    def snapshot(self):
+        snapshot = self.sorted_dict.snapshot()
+        assert snapshot.snapshot() is snapshot
+        assert snapshot.key_type is self.key_type
+        # Keep only a few, so that the sorted dictionary is sometimes modified
+        # after all snapshots sharing its keys and values are gone.
+        self.snapshots = [*self.snapshots[-2:], (snapshot, repr(self.sorted_dict))]
+
+    @rule()
+    def snapshot_drop(self):
+        self.snapshots.clear()
+
+    @precondition(prec_snapshots_not_empty)
+    @rule(key=all_keys, value=st.integers())
+    def snapshot_setitem(self, key, value):
+        snapshot, _ = self.snapshots[-1]
+        with pytest.raises(TypeError, match="operation not permitted: sorted dictionary is a snapshot"):
+            snapshot[key] = value
+
     ###########################################################################
     # `update` without changes.
     ###########################################################################
@@ -842,6 +1423,60 @@ class FuzzMachine(RuleBasedStateMachine):
         self.normal_dict.update(good_other)
         self.sorted_dict.update(dict(good_other))
 
+    ###########################################################################
+    # `update`, `or` and `ior` with a sorted dictionary.
+    ###########################################################################
+
+    @precondition(prec_key_type_not_set)
+    @rule(good_other=rule_items_supported(), inplace_or=st.booleans())
+    def update_sorted_dict_empty(self, good_other, inplace_or):
+        self.key_type = type(good_other[0][0])
+        self.normal_dict.update(good_other)
+        if inplace_or:
+            sorted_dict = self.sorted_dict
+            sorted_dict |= SortedDict(good_other)
+            assert sorted_dict is self.sorted_dict
+        else:
+            self.sorted_dict.update(SortedDict(good_other))
+
+    @precondition(prec_key_type_set)
+    @rule(bad_other=rule_items_wrong_type())
+    def update_sorted_dict_wrong_type(self, bad_other):
+        key = bad_other[0][0]
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict.update(SortedDict(bad_other[:1]))
+        with pytest.raises(
+            TypeError, match=re.escape(f"got key {key!r} of type {type(key)}, want key of type {self.key_type}")
+        ):
+            self.sorted_dict | SortedDict(bad_other[:1])
+
+    @precondition(prec_key_type_set)
+    @rule(good_other=rule_items_right_type(), inplace_or=st.booleans())
+    def update_sorted_dict(self, good_other, inplace_or):
+        self.normal_dict.update(good_other)
+        if inplace_or:
+            sorted_dict = self.sorted_dict
+            sorted_dict |= SortedDict(good_other)
+            assert sorted_dict is self.sorted_dict
+        else:
+            self.sorted_dict.update(SortedDict(good_other))
+
+    @precondition(prec_key_type_set)
+    @rule(good_other=rule_items_right_type())
+    def or_sorted_dict(self, good_other):
+        sorted_dict = self.sorted_dict | SortedDict(good_other)
+        assert sorted_dict is not self.sorted_dict
+        assert [*sorted_dict.items()] == sorted({**self.normal_dict, **dict(good_other)}.items())
+
+    @rule(other=st.sampled_from(({}, [], None)))
+    def or_not_sorted_dict(self, other):
+        with pytest.raises(TypeError, match=re.escape("unsupported operand type(s) for |")):
+            self.sorted_dict | other
+        with pytest.raises(TypeError, match=re.escape("unsupported operand type(s) for |")):
+            other | self.sorted_dict
+
     ###########################################################################
     # `update` with an iterable.
     ###########################################################################
@@ -909,6 +1544,14 @@ class FuzzMachine(RuleBasedStateMachine):
         self.normal_dict.update(good_other)
         self.sorted_dict.update(good_other)
 
+    @precondition(prec_key_type_not_set)
+    @rule(good_other=rule_items_supported())
+    def update2_sorted_empty(self, good_other):
+        self.key_type = type(good_other[0][0])
+        good_other = sorted(dict(good_other).items())
+        self.normal_dict.update(good_other)
+        self.sorted_dict.update(good_other)
+
     @precondition(prec_key_type_set)
     @rule(bad_other=rule_items_wrong_type())
     def update2_unsupported(self, bad_other):
@@ -1,9 +1,17 @@
+import pickle
+import struct
 import sys
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from datetime import date, timedelta
 from importlib.metadata import version
+from ipaddress import IPv6Address
+from operator import neg
+from uuid import UUID
 
 import pytest
 
-from pysorteddict import SortedDict, __version__
+from pysorteddict import FrozenSortedDict, SortedDict, __version__
 
 
 def test_key_repr_error():
@@ -31,12 +39,405 @@ def test_remove_first_element_while_referenced_by_reverse_iterator():
         next(r)
 
 
+def test_irange_remove_elements_while_referenced_by_reverse_iterator():
+    sorted_dict = SortedDict()
+    for key in range(10):
+        sorted_dict[key] = key
+    r = sorted_dict.irange(3, 7, reverse=True)
+    assert next(r) == 7
+    assert next(r) == 6
+    del sorted_dict[5]
+    del sorted_dict[4]
+    del sorted_dict[3]
+    with pytest.raises(StopIteration):
+        next(r)
+    del sorted_dict[6]
+
+
+def test_update_equal_keys_keeps_first_key():
+    sorted_dict = SortedDict([(0.0, 0), (1.0, 1), (-0.0, 2)])
+    assert repr(sorted_dict) == "SortedDict({0.0: 2, 1.0: 1})"
+    sorted_dict.update([(-1.0, 3), (2.0, 4), (-0.0, 5)])
+    assert repr(sorted_dict) == "SortedDict({-1.0: 3, 0.0: 5, 1.0: 1, 2.0: 4})"
+
+
+def test_update_released_value_modifies_sorted_dict():
+    sorted_dict = SortedDict()
+
+    class Deleter:
+        def __del__(self):
+            del sorted_dict[1]
+
+    sorted_dict.update({1: Deleter(), 2: 0, 3: 0})
+    sorted_dict.update({1: "a", 2: "b"})
+    assert list(sorted_dict.items()) == [(2, "b"), (3, 0)]
+
+
+def test_update_released_duplicate_modifies_empty_sorted_dict():
+    sorted_dict = SortedDict()
+
+    class Inserter:
+        def __del__(self):
+            sorted_dict[0] = "x"
+
+    def items():
+        yield 1, Inserter()
+        yield 1, "a"
+        yield 2, "b"
+
+    sorted_dict.update(items())
+    assert list(sorted_dict.items()) == [(0, "x"), (1, "a"), (2, "b")]
+
+
+def test_modify_while_referenced_by_iterators_and_snapshots():
+    sorted_dict = SortedDict()
+    for key in range(10):
+        sorted_dict[key] = key
+    f = iter(sorted_dict)
+    r = reversed(sorted_dict)
+    assert next(f) == 0
+    assert next(r) == 9
+    snapshots = [sorted_dict.snapshot()]
+    sorted_dict[10] = 10
+    snapshots.append(sorted_dict.snapshot())
+    del sorted_dict[5]
+    with pytest.raises(RuntimeError, match=r"key-value pair locked by 1 iterator\(s\)"):
+        del sorted_dict[1]
+    snapshots.clear()
+    assert [*f] == [1, 2, 3, 4, 6, 7, 8, 9, 10]
+    assert [*r] == [8, 7, 6, 4, 3, 2, 1, 0]
+    del sorted_dict[1]
+
+
+def test_delete_range_while_referenced_by_iterators_and_snapshots():
+    sorted_dict = SortedDict()
+    for key in range(1000):
+        sorted_dict[key] = key
+    f = iter(sorted_dict)
+    assert next(f) == 0
+    snapshot = sorted_dict.snapshot()
+    with pytest.raises(RuntimeError, match=r"key-value pair locked by 1 iterator\(s\)"):
+        sorted_dict.delete_range(0, 500)
+    assert len(sorted_dict) == 1000
+    sorted_dict.delete_range(1, 500, (False, False))
+    del sorted_dict.keys()[-100:]
+    del sorted_dict.keys()[2::2]
+    assert [*f] == [1, *range(501, 900, 2)]
+    assert len(snapshot) == 1000
+    with pytest.raises(TypeError, match="sorted dictionary is a snapshot"):
+        del snapshot.keys()[0]
+
+
+def test_modify_after_failing_to_modify_while_shared_with_snapshots():
+    sorted_dict = SortedDict()
+    for key in range(0, 2000, 2):
+        sorted_dict[key] = key
+    snapshot = sorted_dict.snapshot()
+    with pytest.raises(KeyError):
+        sorted_dict.pop(1001)
+    with pytest.raises(KeyError):
+        del sorted_dict[1001]
+    with pytest.raises(TypeError):
+        sorted_dict["a"] = 0
+    sorted_dict.delete_range(600, 500)
+    del sorted_dict.keys()[500:500]
+    assert sorted_dict.pop(700) == 700
+    assert list(snapshot.items()) == [(key, key) for key in range(0, 2000, 2)]
+    assert list(sorted_dict.items()) == [(key, key) for key in range(0, 2000, 2) if key != 700]
+
+    operations = [
+        (lambda: sorted_dict.__setitem__(300, "a"), lambda d: d.update({300: "a"})),
+        (lambda: sorted_dict.__setitem__(301, "b"), lambda d: d.update({301: "b"})),
+        (lambda: sorted_dict.__delitem__(302), lambda d: d.pop(302)),
+        (lambda: sorted_dict.setdefault(305, "c"), lambda d: d.setdefault(305, "c")),
+        (lambda: sorted_dict.popitem(400), lambda d: d.pop(sorted(d)[400])),
+        (lambda: sorted_dict.delete_range(500, 550), lambda d: [d.pop(key) for key in range(500, 551, 2)]),
+        (
+            lambda: sorted_dict.keys().__delitem__(slice(800, 900, 3)),
+            lambda d: [d.pop(key) for key in sorted(d)[800:900:3]],
+        ),
+        (lambda: sorted_dict.update({0: "d", 1: "e"}), lambda d: d.update({0: "d", 1: "e"})),
+    ]
+    for operation, expected_operation in operations:
+        snapshot = sorted_dict.snapshot()
+        expected = dict(sorted_dict.items())
+        items = list(expected.items())
+        operation()
+        expected_operation(expected)
+        assert list(snapshot.items()) == items
+        assert list(sorted_dict.items()) == sorted(expected.items())
+
+
+def test_irange_next_chunk_remove_elements():
+    sorted_dict = SortedDict()
+    for key in range(10):
+        sorted_dict[key] = key
+    f = sorted_dict.irange(2, 7)
+    r = sorted_dict.irange(2, 7, reverse=True)
+    assert f.next_chunk(2) == [2, 3]
+    assert r.next_chunk(2) == [7, 6]
+    with pytest.raises(RuntimeError, match=r"key-value pair locked by 1 iterator\(s\)"):
+        del sorted_dict[4]
+    del sorted_dict[5]
+    assert f.next_chunk(10) == [4, 6, 7]
+    assert f.next_chunk(10) == []
+    assert r.next_chunk(10) == [4, 3, 2]
+    with pytest.raises(StopIteration):
+        next(r)
+    sorted_dict.clear()
+
+
+def test_pop_while_referenced_by_reverse_iterator():
+    sorted_dict = SortedDict()
+    for key in range(10):
+        sorted_dict[key] = key
+    r = reversed(sorted_dict)
+    assert next(r) == 9
+    with pytest.raises(RuntimeError, match=r"key-value pair locked by 1 iterator\(s\)"):
+        sorted_dict.popitem()
+    assert sorted_dict.peekitem() == (9, 9)
+    assert sorted_dict.popitem(0) == (0, 0)
+    assert sorted_dict.popitem(-2) == (8, 8)
+    assert sorted_dict.pop(7) == 7
+    assert [*r] == [6, 5, 4, 3, 2, 1]
+
+
+def test_items_iterator_result_not_overwritten_while_referenced():
+    sorted_dict = SortedDict()
+    for key in range(10):
+        sorted_dict[key] = [key]
+    iterator = iter(sorted_dict.items())
+    kept = [next(iterator)]
+    for key, value in iterator:
+        assert value == [key]
+        if key in (3, 6):
+            kept.append(next(iterator))
+    assert kept == [(0, [0]), (4, [4]), (7, [7])]
+    iterator = reversed(sorted_dict.items())
+    assert [item for item in iterator if item[0] % 2 == 0] == [(key, [key]) for key in range(8, -1, -2)]
+
+    # A reused result must not keep the hash of the key-value pair it held.
+    sorted_dict = SortedDict({key: str(key) for key in range(10)})
+    assert [hash(item) for item in sorted_dict.items()] == [hash((key, str(key))) for key in range(10)]
+    assert {*sorted_dict.items()} == {(key, str(key)) for key in range(10)}
+
+
+@pytest.mark.parametrize(
+    "keys",
+    [
+        [date.max, date(2000, 2, 1), date.min, date(1999, 12, 31), date(2000, 1, 31)],
+        [timedelta.max, timedelta(microseconds=-1), timedelta.min, timedelta(), timedelta(days=-1, seconds=86399)],
+        [IPv6Address(2**128 - 1), IPv6Address(2**64), IPv6Address(0), IPv6Address(2**64 - 1), IPv6Address("::1%1")],
+        [UUID(int=2**128 - 1), UUID(int=2**64), UUID(int=0), UUID(int=2**64 - 1), UUID(int=2**63)],
+    ],
+)
+def test_unboxed_keys_extremes(keys):
+    sorted_dict = SortedDict(dict.fromkeys(keys))
+    assert list(sorted_dict) == sorted(keys)
+    assert all(key in sorted_dict for key in keys)
+
+
+@pytest.mark.parametrize(
+    "keys",
+    [
+        ["abcdefgh", "abcdefg", "abcdefg\0", "abcdefgh\0", "abcdefghi", "", "\0", "\x7f", "\x80", "\xff\0", "\u0100"],
+        ["\u07ff", "\u0800", "\ud800", "\udfff", "\uffff", "\U00010000", "\U0010ffff", "a\U0010ffff", "aaaaaaa\u0800"],
+        [b"abcdefgh", b"abcdefg", b"abcdefg\0", b"abcdefgh\0", b"", b"\0", b"\0\0", b"\x7f", b"\x80", b"\xff" * 9],
+    ],
+)
+def test_abbreviated_keys_ties(keys):
+    sorted_dict = SortedDict(dict.fromkeys(keys))
+    assert list(sorted_dict) == sorted(keys)
+    assert all(key in sorted_dict for key in keys)
+
+
+def test_unboxed_keys_ipv6_scope_ignored():
+    sorted_dict = SortedDict({IPv6Address("fe80::1%eth0"): 0, IPv6Address("fe80::"): 1})
+    sorted_dict[IPv6Address("fe80::1%eth1")] = 2
+    assert list(sorted_dict.items()) == [(IPv6Address("fe80::"), 1), (IPv6Address("fe80::1%eth0"), 2)]
+
+
+def test_tuple_keys():
+    sorted_dict = SortedDict({("b", 2): 0, ("a", 10**30): 1, ("a", -(2**70)): 2, ("a", 2**63): 3, ("a", -1): 4})
+    assert list(sorted_dict) == [("a", -(2**70)), ("a", -1), ("a", 2**63), ("a", 10**30), ("b", 2)]
+    assert list(sorted_dict.irange(("a", 0), ("a", 2**64))) == [("a", 2**63)]
+    assert ("a", -1) in sorted_dict
+    with pytest.raises(TypeError, match=r"got key \('a', 1.0\) with element types \(<class 'str'>, <class 'float'>\)"):
+        sorted_dict.get(("a", 1.0))
+    with pytest.raises(TypeError, match=r"want key with element types \(<class 'str'>, <class 'int'>\)"):
+        sorted_dict[("a",)] = 5
+    sorted_dict.clear()
+    with pytest.raises(TypeError, match="want key with element types"):
+        sorted_dict[("a", "b")] = 5
+    frozen_sorted_dict = FrozenSortedDict({("b", 1.5): 0, ("a", 2.5): 1})
+    assert frozen_sorted_dict.bisect_left(("b", 0.0)) == 1
+    with pytest.raises(TypeError, match="want key with element types"):
+        frozen_sorted_dict.bisect_left(("b", 0))
+
+
+def test_tuple_keys_bad_elements():
+    sorted_dict = SortedDict()
+    with pytest.raises(
+        TypeError, match=r"got key \(1, \(2,\)\) with element \(2,\) of unsupported type <class 'tuple'>"
+    ):
+        sorted_dict[(1, (2,))] = 0
+    assert sorted_dict.key_type is None
+    with pytest.raises(ValueError, match=r"got bad key \(1, nan\) of type <class 'tuple'>"):
+        sorted_dict[(1, float("nan"))] = 0
+    assert sorted_dict.key_type is None
+    sorted_dict[(1, 2.0)] = 0
+    with pytest.raises(ValueError, match=r"got bad key \(1, nan\) of type <class 'tuple'>"):
+        sorted_dict.get((1, float("nan")))
+
+
+def test_key_function():
+    sorted_dict = SortedDict({"b": 0, "A": 1, "c": 2}, key=str.lower)
+    assert sorted_dict.key is str.lower
+    assert list(sorted_dict.items()) == [("A", 1), ("b", 0), ("c", 2)]
+    assert "a" in sorted_dict
+    assert sorted_dict["B"] == 0
+    sorted_dict["a"] = 3
+    assert list(sorted_dict.items()) == [("A", 3), ("b", 0), ("c", 2)]
+    assert sorted_dict.bisect_left("B") == sorted_dict.index("b") == 1
+    assert list(sorted_dict.irange("B", "C")) == ["b", "c"]
+    assert sorted_dict.peekitem() == ("c", 2)
+    assert sorted_dict.popitem(0) == ("A", 3)
+    assert sorted_dict.pop("C") == 2
+    sorted_dict.delete_range("a", "z")
+    assert not sorted_dict
+    assert sorted_dict.key_type is str
+
+
+def test_key_function_errors():
+    with pytest.raises(TypeError, match="got key function 0 of type <class 'int'>, want callable"):
+        SortedDict(key=0)
+    sorted_dict = SortedDict({1: 0}, key=abs)
+    with pytest.raises(TypeError, match="bad operand type for abs"):
+        sorted_dict["a"] = 0
+    with pytest.raises(TypeError, match="got key 1.5 of type <class 'float'>, want key of type <class 'int'>"):
+        sorted_dict[-1.5] = 0
+    with pytest.raises(ValueError, match="cannot change key function of non-empty sorted dictionary"):
+        sorted_dict.__init__(key=None)
+    with pytest.raises(TypeError, match="operation not permitted: sorted dictionary has a key function"):
+        sorted_dict.keys().to_buffer()
+    sorted_dict.clear()
+    sorted_dict.__init__(key=None)
+    assert sorted_dict.key is None
+
+
+def test_key_function_update_and_pickle():
+    sorted_dict = SortedDict({-2: 0, 1: 1}, key=abs)
+    sorted_dict.update(SortedDict({2: 2, -3: 3}))
+    assert list(sorted_dict.items()) == [(1, 1), (-2, 2), (-3, 3)]
+    other = SortedDict({4: 4}, key=neg)
+    other.update(sorted_dict)
+    assert list(other.items()) == [(4, 4), (1, 1), (-2, 2), (-3, 3)]
+    assert list(pickle.loads(pickle.dumps(sorted_dict)).items()) == list(sorted_dict.items())
+    frozen_sorted_dict = FrozenSortedDict(sorted_dict, key=neg)
+    assert frozen_sorted_dict.key is neg
+    assert frozen_sorted_dict.keys() == (1, -2, -3)
+    assert frozen_sorted_dict[-2] == 2
+    copy = pickle.loads(pickle.dumps(frozen_sorted_dict))
+    assert copy.key is neg
+    assert copy == frozen_sorted_dict
+
+
+def test_setstate_unsorted_and_duplicate_keys():
+    sorted_dict = SortedDict()
+    sorted_dict.__setstate__((int, [3, 1, 2, 2], ["a", "b", "c", "d"]))
+    assert list(sorted_dict.items()) == [(1, "b"), (2, "d"), (3, "a")]
+    assert all(key in sorted_dict for key in (1, 2, 3))
+    sorted_dict = SortedDict()
+    sorted_dict.__setstate__((float, struct.pack("<4d", 3.0, 1.0, 2.0, 1.0), [0, 1, 2, 3]))
+    assert list(sorted_dict.items()) == [(1.0, 3), (2.0, 2), (3.0, 0)]
+    assert all(key in sorted_dict for key in (1.0, 2.0, 3.0))
+
+
+def test_setstate_bad_packed_keys():
+    sorted_dict = SortedDict()
+    with pytest.raises(ValueError, match="got packed keys of size 7, want size divisible by 8"):
+        sorted_dict.__setstate__((int, bytes(7), [0]))
+    with pytest.raises(ValueError, match="got 2 keys and 1 values, want as many keys as values"):
+        sorted_dict.__setstate__((int, bytes(16), [0]))
+    with pytest.raises(TypeError, match="got packed keys, want key type <class 'float'> or <class 'int'>"):
+        sorted_dict.__setstate__((str, bytes(8), [0]))
+    sorted_dict.__setstate__((float, bytes(8), [0]))
+    assert list(sorted_dict.items()) == [(0.0, 0)]
+
+
+def test_frozen_empty():
+    frozen_sorted_dict = FrozenSortedDict()
+    assert frozen_sorted_dict.key_type is None
+    assert 0 not in frozen_sorted_dict
+    assert frozen_sorted_dict.bisect_left("a") == frozen_sorted_dict.bisect_right(b"a") == 0
+    with pytest.raises(KeyError, match="0"):
+        frozen_sorted_dict[0]
+    assert frozen_sorted_dict == FrozenSortedDict(SortedDict())
+    assert hash(frozen_sorted_dict) == hash(FrozenSortedDict([]))
+
+
+def test_frozen_unaffected_by_modification():
+    sorted_dict = SortedDict({"b": 0, "a": 1})
+    frozen_sorted_dict = FrozenSortedDict(sorted_dict)
+    sorted_dict["c"] = 2
+    del sorted_dict["a"]
+    assert frozen_sorted_dict.items() == (("a", 1), ("b", 0))
+    with pytest.raises(TypeError, match="does not support item assignment"):
+        frozen_sorted_dict["c"] = 2
+
+
+def test_concurrent_access():
+    sorted_dict = SortedDict()
+    barrier = threading.Barrier(8)
+
+    def write(offset):
+        barrier.wait()
+        for key in range(offset, 4000, 4):
+            sorted_dict[key] = key
+        for key in range(offset, 4000, 8):
+            while True:
+                try:
+                    del sorted_dict[key]
+                    break
+                except RuntimeError:
+                    # An iterator in another thread references this key.
+                    pass
+
+    def read():
+        barrier.wait()
+        for _ in range(50):
+            keys = list(sorted_dict)
+            assert keys == sorted(keys)
+            for key in keys[::97]:
+                assert sorted_dict.get(key, key) == key
+
+    with ThreadPoolExecutor(8) as executor:
+        futures = [executor.submit(write, offset) for offset in range(4)]
+        futures.extend(executor.submit(read) for _ in range(4))
+        for future in futures:
+            future.result()
+    assert list(sorted_dict) == [key for key in range(4000) if key % 8 >= 4]
+
+
+def test_subinterpreter():
+    interpreters = pytest.importorskip("concurrent.interpreters")
+    interpreter = interpreters.create()
+    interpreter.exec(
+        "from pysorteddict import SortedDict\n"
+        "sorted_dict = SortedDict({'b': 0, 'a': 1})\n"
+        "assert list(sorted_dict.items()) == [('a', 1), ('b', 0)]\n"
+    )
+    interpreter.close()
+
+
 def test_type_hint():
     SortedDict[str, float]
+    FrozenSortedDict[str, float]
 
 
 def test_subclassable():
     type("SortedDictSubclass", (SortedDict,), {})
+    type("FrozenSortedDictSubclass", (FrozenSortedDict,), {})
 
 
 def test_version():